@@ -0,0 +1,93 @@
+//===--------------------------------------------------------------------------------------------===
+// csi_bench.c - compares the control sequence encoder with the printf path it replaced
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#include "csi.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define ITERATIONS 10000000
+
+static volatile unsigned sink = 0;
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void report(const char* name, double printfTime, double csiTime) {
+    printf("%-16s printf: %6.2f ns/op   csi: %6.2f ns/op   (%.1fx)\n",
+           name,
+           printfTime * 1e9 / ITERATIONS,
+           csiTime * 1e9 / ITERATIONS,
+           printfTime / csiTime);
+}
+
+static void bench_cursor_go() {
+    char buffer[CSI_MAX_LENGTH];
+
+    double start = now();
+    for(int i = 0; i < ITERATIONS; ++i) {
+        int length = snprintf(buffer, sizeof(buffer), "\033[%d;%dH", (i % 60) + 1, (i % 200) + 1);
+        sink += buffer[length - 1];
+    }
+    double printfTime = now() - start;
+
+    start = now();
+    for(int i = 0; i < ITERATIONS; ++i) {
+        int length = csi_cursor_go(buffer, i % 200, i % 60);
+        sink += buffer[length - 1];
+    }
+    report("cursor go", printfTime, now() - start);
+}
+
+static void bench_cursor_move() {
+    char buffer[CSI_MAX_LENGTH];
+
+    double start = now();
+    for(int i = 0; i < ITERATIONS; ++i) {
+        int length = snprintf(buffer, sizeof(buffer), "\033[%dC", (i % 80) + 1);
+        sink += buffer[length - 1];
+    }
+    double printfTime = now() - start;
+
+    start = now();
+    for(int i = 0; i < ITERATIONS; ++i) {
+        int length = csi_cursor_move(buffer, (i % 80) + 1, 'C');
+        sink += buffer[length - 1];
+    }
+    report("cursor move", printfTime, now() - start);
+}
+
+static void bench_sgr() {
+    char buffer[CSI_MAX_LENGTH];
+
+    double start = now();
+    for(int i = 0; i < ITERATIONS; ++i) {
+        int length = snprintf(buffer, sizeof(buffer), "\033[%d;%d;%dm", 1, 30 + (i % 8), 40 + (i % 8));
+        sink += buffer[length - 1];
+    }
+    double printfTime = now() - start;
+
+    start = now();
+    for(int i = 0; i < ITERATIONS; ++i) {
+        int params[] = {1, 30 + (i % 8), 40 + (i % 8)};
+        int length = csi_sgr(buffer, params, 3);
+        sink += buffer[length - 1];
+    }
+    report("sgr", printfTime, now() - start);
+}
+
+int main() {
+    bench_cursor_go();
+    bench_cursor_move();
+    bench_sgr();
+    return sink == 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+//===--------------------------------------------------------------------------------------------===
+// render_bench.c - measures what the editor sends to the terminal, on a virtual terminal
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#include <term/editor.h>
+#include <term/hexes.h>
+#include <term/latency.h>
+#include <term/vterm.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define WIDTH 120
+#define HEIGHT 40
+#define LINES 400
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Sends [key] [count] times in batches of [batch], rendering after each event like an interactive
+// session would. Batches larger than one are what key repeat looks like to the program.
+static void run(hexes_vt_t* vt, const char* name, const char* key, int count, int batch) {
+    hexes_vt_reset_stats(vt);
+    hexes_latency_reset();
+    double start = now();
+    for(int i = 0; i < count; i += batch) {
+        for(int j = 0; j < batch; ++j) hexes_vt_input(vt, key, strlen(key));
+        hexes_event_t event;
+        while(hexes_poll_event(&event, 0) > 0) {
+            termEditorHandle(&event);
+            termEditorRender();
+        }
+    }
+    double time = now() - start;
+
+    const hexes_vt_stats_t* stats = hexes_vt_stats(vt);
+    hexes_latency_t latency = hexes_latency(HEXES_LATENCY_EDITOR);
+    printf("%-12s %6d events  %8.1f bytes/event  %6.1f cells/event  %6.1f changed/event  "
+           "%6.2f us/event  %6.1f us p99\n",
+           name,
+           count,
+           (double)stats->bytes / count,
+           (double)stats->cells / count,
+           (double)stats->changed / count,
+           time * 1e6 / count,
+           latency.p99 * 1000);
+}
+
+int main() {
+    hexes_vt_t* vt = hexes_vt_new(WIDTH, HEIGHT);
+    hexes_set_backend(hexes_vt_backend(vt));
+
+    static char text[LINES * 64];
+    int length = 0;
+    for(int i = 0; i < LINES; ++i) {
+        length += snprintf(text + length, sizeof(text) - length,
+                           "%4d: the quick brown fox jumps over the lazy dog\n", i);
+    }
+
+    termEditorInit("bench");
+    hexes_vt_reset_stats(vt);
+    termEditorReplace(text);
+    termEditorRender();
+    const hexes_vt_stats_t* stats = hexes_vt_stats(vt);
+    printf("%-12s %6d events  %8ld bytes/event  %6ld cells/event  %6ld changed/event\n",
+           "first paint", 1, stats->bytes, stats->cells, stats->changed);
+
+    run(vt, "typing", "x", 500, 1);
+    run(vt, "arrow right", "\033[C", 200, 1);
+    run(vt, "scroll down", "\033[B", LINES - 1, 1);
+    run(vt, "scroll up", "\033[A", LINES - 1, 1);
+    run(vt, "backspace", "\177", 200, 1);
+    run(vt, "repeat down", "\033[B", LINES - 1, 8);
+    run(vt, "repeat up", "\033[A", LINES - 1, 8);
+
+    termEditorDeinit();
+    hexes_set_backend(NULL);
+    hexes_vt_destroy(vt);
+    return 0;
+}
@@ -11,6 +11,7 @@
 #include <stdint.h>
 #include <term/arg.h>
 #include <term/colors.h>
+#include <term/width.h>
 
 static inline void pad(FILE* out, uint8_t count) {
     fprintf(out, "%*s", (int)count, "");
@@ -55,8 +56,11 @@ static void print_param(FILE* out, const term_param_t* param, uint8_t start) {
     else
         col += fprintf(out, "    ");
     
-    if(param->long_name)
-        col += fprintf(out, " --%s", param->long_name);
+    // Long names can be in any script: what matters for alignment is the columns they take up.
+    if(param->long_name) {
+        fprintf(out, " --%s", param->long_name);
+        col += 3 + term_display_width(param->long_name, strlen(param->long_name));
+    }
 
     if(param->description) {
         print_aligned(out, param->description, col, start);
@@ -68,8 +72,7 @@ static void print_param(FILE* out, const term_param_t* param, uint8_t start) {
 static const term_param_t help = {'h', 0, "help", 0, "print this help message"};
 
 void term_print_help(FILE* out, const term_param_t* params, int count) {
-    term_style_reset(out);
-    term_set_bold(out, true);
+    term_set_style(out, (term_style_t){TERM_DEFAULT, TERM_DEFAULT, true, false, false});
     printf("Options\n");
     term_style_reset(out);
 
@@ -0,0 +1,223 @@
+//===--------------------------------------------------------------------------------------------===
+// caps.c - terminal capability detection, with an on-disk cache
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#include <term/hexes.h>
+#include <term/backend.h>
+#include "input.h"
+#include "instrument.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+// How long we wait for the terminal's replies when nothing is cached, in milliseconds. Terminals
+// answer the final DA1 request straight away, so this is only ever spent on unusual ones.
+#define CAPS_PROBE_TIMEOUT 100
+#define CAPS_MAX_PATH 1024
+
+// Every query goes out in a single write and is answered in order. Primary device attributes
+// come last: every terminal answers it, so its reply means there is nothing else to wait for.
+static const char probe[] =
+    "\033[?2026$p"  // DECRQM: synchronized output
+    "\033[?2004$p"  // DECRQM: bracketed paste
+    "\033[>0q"      // XTVERSION
+    "\033[?u"       // Kitty keyboard protocol flags
+    "\033[c";       // DA1
+#define CAPS_PROBE_QUERIES 5
+
+static hexes_caps_t caps;
+static const hexes_backend_t* capsBackend = NULL;   // The backend [caps] describes.
+
+static bool has_truecolor() {
+    const char* colorterm = getenv("COLORTERM");
+    return colorterm && (!strcmp(colorterm, "truecolor") || !strcmp(colorterm, "24bit"));
+}
+
+#ifndef _WIN32
+
+// MARK: - Cache
+
+static const char* env_or(const char* name, const char* fallback) {
+    const char* value = getenv(name);
+    return value && *value ? value : fallback;
+}
+
+// Creates [path]'s parent directories, leaving the path untouched.
+static void make_parents(char* path) {
+    for(char* c = path + 1; *c; ++c) {
+        if(*c != '/') continue;
+        *c = '\0';
+        mkdir(path, 0700);
+        *c = '/';
+    }
+}
+
+// One small file per terminal, named after the environment that identifies it.
+static bool cache_path(char* path, int size) {
+    const char* base = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    int length = 0;
+    if(base && *base == '/')
+        length = snprintf(path, size, "%s/termutils/caps/", base);
+    else if(home && *home)
+        length = snprintf(path, size, "%s/.cache/termutils/caps/", home);
+    else
+        return false;
+    if(length <= 0 || length >= size) return false;
+
+    const char* key[] = {
+        env_or("TERM", "unknown"),
+        env_or("TERM_PROGRAM", "none"),
+        env_or("TERM_PROGRAM_VERSION", "none"),
+    };
+    for(int i = 0; i < 3; ++i) {
+        for(const char* c = key[i]; *c && length < size - 2; ++c) {
+            // Keep the name safe to use as a file name, whatever the variables contain.
+            bool safe = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z')
+                || (*c >= '0' && *c <= '9') || *c == '.' || *c == '-' || *c == '_';
+            path[length++] = safe ? *c : '_';
+        }
+        path[length++] = i < 2 ? '+' : '\0';
+    }
+    return length < size;
+}
+
+static bool cache_load(hexes_caps_t* out) {
+    char path[CAPS_MAX_PATH];
+    if(!cache_path(path, sizeof(path))) return false;
+    FILE* file = fopen(path, "r");
+    if(!file) return false;
+
+    int sync = 0, paste = 0, kitty = 0;
+    int read = fscanf(file, "termutils-caps 1\nsync %d\npaste %d\nkitty %d\nversion ",
+                      &sync, &paste, &kitty);
+    if(read != 3) {
+        fclose(file);
+        return false;
+    }
+    if(!fgets(out->version, sizeof(out->version), file)) out->version[0] = '\0';
+    out->version[strcspn(out->version, "\n")] = '\0';
+    fclose(file);
+
+    out->sync = sync;
+    out->bracketedPaste = paste;
+    out->kittyKeyboard = kitty;
+    return true;
+}
+
+static void cache_store(const hexes_caps_t* caps) {
+    char path[CAPS_MAX_PATH];
+    char temp[CAPS_MAX_PATH + 16];
+    if(!cache_path(path, sizeof(path))) return;
+    make_parents(path);
+
+    // Write the whole thing next to its final name, so other programs starting at the same time
+    // never see half a file.
+    snprintf(temp, sizeof(temp), "%s.%ld", path, (long)getpid());
+    FILE* file = fopen(temp, "w");
+    if(!file) return;
+    fprintf(file, "termutils-caps 1\nsync %d\npaste %d\nkitty %d\nversion %s\n",
+            caps->sync, caps->bracketedPaste, caps->kittyKeyboard, caps->version);
+    if(fclose(file) != 0 || rename(temp, path) != 0) remove(temp);
+}
+
+// MARK: - Probing
+
+// Sends every query at once, and reads the replies until the terminal answers DA1. Returns whether
+// it did: without that, we can't tell a missing feature from a slow or silent terminal.
+static bool probe_terminal(hexes_caps_t* out) {
+    bool hadSession = hexes_session_active();
+    hexes_session_begin();
+
+    // The queries go straight to the backend: they aren't part of what the terminal shows, and
+    // session recordings shouldn't replay them.
+    const hexes_backend_t* backend = hexes_get_backend();
+    if(backend == hexes_terminal_backend()) {
+        fflush(stdout);
+    } else {
+        STATS_ADD(writes, 1);
+        STATS_ADD(bytes, sizeof(probe) - 1);
+    }
+    backend->write(backend->context, probe, sizeof(probe) - 1);
+    STATS_ADD(escapes[TERM_ESCAPE_OTHER], CAPS_PROBE_QUERIES);
+
+    bool answered = false;
+    input_report_t report;
+    while(!answered && input_wait_report(&report, CAPS_PROBE_TIMEOUT)) {
+        if(report.kind == INPUT_REPORT_DCS) {
+            if(report.prefix == '>' && report.final == '|') {
+                strncpy(out->version, report.text, sizeof(out->version) - 1);
+                out->version[sizeof(out->version) - 1] = '\0';
+            }
+            continue;
+        }
+        if(report.prefix != '?') continue;
+
+        switch(report.final) {
+        case 'y':
+            // DECRPM: 1 and 2 mean set and reset, 0 and 4 unknown and permanently reset.
+            if(report.intermediate != '$' || report.count < 2) break;
+            if(report.params[0] == 2026) out->sync = report.params[1] == 1 || report.params[1] == 2;
+            if(report.params[0] == 2004)
+                out->bracketedPaste = report.params[1] == 1 || report.params[1] == 2;
+            break;
+        case 'u': out->kittyKeyboard = true; break;
+        case 'c': answered = true; break;
+        default: break;
+        }
+    }
+
+    if(!hadSession) hexes_session_end();
+    return answered;
+}
+
+#endif
+
+// MARK: - Public API
+
+// The cache only describes the process's own terminal: other backends are always asked.
+static bool is_terminal() {
+    return hexes_get_backend() == hexes_terminal_backend();
+}
+
+static bool is_tty() {
+#ifdef _WIN32
+    return false;
+#else
+    return isatty(STDIN_FILENO) && isatty(STDOUT_FILENO);
+#endif
+}
+
+const hexes_caps_t* hexes_caps_probe() {
+    caps = (hexes_caps_t){.truecolor = has_truecolor()};
+    capsBackend = hexes_get_backend();
+#ifndef _WIN32
+    if(is_terminal() && !is_tty()) return &caps;
+    if(probe_terminal(&caps) && is_terminal()) cache_store(&caps);
+#endif
+    return &caps;
+}
+
+const hexes_caps_t* hexes_caps() {
+    if(capsBackend == hexes_get_backend()) return &caps;
+#ifndef _WIN32
+    if(is_terminal() && is_tty()) {
+        caps = (hexes_caps_t){.truecolor = has_truecolor()};
+        if(cache_load(&caps)) {
+            capsBackend = hexes_get_backend();
+            return &caps;
+        }
+    }
+#endif
+    return hexes_caps_probe();
+}
@@ -8,7 +8,16 @@
 // =^•.•^=
 //===--------------------------------------------------------------------------------------------===
 #include <term/colors.h>
+#include <term/hexes.h>
+#include <term/backend.h>
+#include "csi.h"
+#include "instrument.h"
+#include "style.h"
 #include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__)) || defined (__MINGW32__)
 #include <unistd.h>
@@ -17,87 +26,517 @@
 #define SUPPORTS_COLOR(file) (false)
 #endif
 
-static const char* _fgColors[] = {
-    [TERM_BLACK] = "\033[30m",
-    [TERM_RED] = "\033[31m",
-    [TERM_GREEN] = "\033[32m",
-    [TERM_YELLOW] = "\033[33m",
-    [TERM_BLUE] = "\033[34m",
-    [TERM_MAGENTA] = "\033[35m",
-    [TERM_CYAN] = "\033[36m",
-    [TERM_WHITE] = "\033[37m",
-    [TERM_DEFAULT] = "\033[39m",
-    [TERM_BRIGHT_BLACK] = "\033[30;1m",
-    [TERM_BRIGHT_RED] = "\033[31;1m",
-    [TERM_BRIGHT_GREEN] = "\033[32;1m",
-    [TERM_BRIGHT_YELLOW] = "\033[33;1m",
-    [TERM_BRIGHT_BLUE] = "\033[34;1m",
-    [TERM_BRIGHT_MAGENTA] = "\033[35;1m",
-    [TERM_BRIGHT_CYAN] = "\033[36;1m",
-    [TERM_BRIGHT_WHITE] = "\033[37m",
-    [TERM_INVALID_COLOR]  = "",
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+// SGR codes for the named colours. Bright colours have codes of their own, so they don't need
+// bold to show, and bold stays the attribute alone.
+static const int _fgCodes[] = {
+    [TERM_BLACK] = 30,
+    [TERM_RED] = 31,
+    [TERM_GREEN] = 32,
+    [TERM_YELLOW] = 33,
+    [TERM_BLUE] = 34,
+    [TERM_MAGENTA] = 35,
+    [TERM_CYAN] = 36,
+    [TERM_WHITE] = 37,
+    [TERM_DEFAULT] = 39,
+    [TERM_BRIGHT_BLACK] = 90,
+    [TERM_BRIGHT_RED] = 91,
+    [TERM_BRIGHT_GREEN] = 92,
+    [TERM_BRIGHT_YELLOW] = 93,
+    [TERM_BRIGHT_BLUE] = 94,
+    [TERM_BRIGHT_MAGENTA] = 95,
+    [TERM_BRIGHT_CYAN] = 96,
+    [TERM_BRIGHT_WHITE] = 97,
+    [TERM_INVALID_COLOR] = 0,
 };
 
-static const char* _bgColors[] = {
-    [TERM_BLACK] = "\033[40m",
-    [TERM_RED] = "\033[41m",
-    [TERM_GREEN] = "\033[42m",
-    [TERM_YELLOW] = "\033[43m",
-    [TERM_BLUE] = "\033[44m",
-    [TERM_MAGENTA] = "\033[45m",
-    [TERM_CYAN] = "\033[46m",
-    [TERM_WHITE] = "\033[47m",
-    [TERM_DEFAULT] = "\033[49m",
-    [TERM_BRIGHT_BLACK] = "\033[40;1m",
-    [TERM_BRIGHT_RED] = "\033[41;1m",
-    [TERM_BRIGHT_GREEN] = "\033[42;1m",
-    [TERM_BRIGHT_YELLOW] = "\033[43;1m",
-    [TERM_BRIGHT_BLUE] = "\033[44;1m",
-    [TERM_BRIGHT_MAGENTA] = "\033[45;1m",
-    [TERM_BRIGHT_CYAN] = "\033[46;1m",
-    [TERM_BRIGHT_WHITE] = "\033[47;1m",
-    [TERM_INVALID_COLOR]  = "",
+static const int _bgCodes[] = {
+    [TERM_BLACK] = 40,
+    [TERM_RED] = 41,
+    [TERM_GREEN] = 42,
+    [TERM_YELLOW] = 43,
+    [TERM_BLUE] = 44,
+    [TERM_MAGENTA] = 45,
+    [TERM_CYAN] = 46,
+    [TERM_WHITE] = 47,
+    [TERM_DEFAULT] = 49,
+    [TERM_BRIGHT_BLACK] = 100,
+    [TERM_BRIGHT_RED] = 101,
+    [TERM_BRIGHT_GREEN] = 102,
+    [TERM_BRIGHT_YELLOW] = 103,
+    [TERM_BRIGHT_BLUE] = 104,
+    [TERM_BRIGHT_MAGENTA] = 105,
+    [TERM_BRIGHT_CYAN] = 106,
+    [TERM_BRIGHT_WHITE] = 107,
+    [TERM_INVALID_COLOR] = 0,
 };
 
+void style_write(FILE* term, const char* data, int length) {
+    if(term == stdout) {
+        hexes_write(data, length);
+    } else {
+        fwrite(data, 1, length, term);
+        STATS_ADD(bytes, length);
+    }
+}
 
-bool term_has_colors(FILE* term) {
+// MARK: - Streams
+
+// How many streams we remember things about. Past that, colour support is checked on every call,
+// and styles are sent in full every time.
+#define TERM_STREAMS 16
+
+typedef struct {
+    FILE* file;
+    term_color_mode_t mode;
+    int colors;         // Whether the stream gets colours when left to us, or -1 if not checked yet.
+    int palette;        // The term_palette_t the stream was given, or -1 to go by the environment.
+    bool known;         // Whether the terminal is in [style].
+    term_style_t style;
+} stream_t;
+
+static stream_t streams[TERM_STREAMS];
+
+// Any thread can print in colour, so the table is only used with the lock held. Output is written
+// once it is released.
+#ifndef _WIN32
+static pthread_mutex_t streamsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void lock_streams() {
+    pthread_mutex_lock(&streamsLock);
+}
+
+static void unlock_streams() {
+    pthread_mutex_unlock(&streamsLock);
+}
+#else
+static void lock_streams() {
+}
+
+static void unlock_streams() {
+}
+#endif
+
+static stream_t* find_stream(FILE* term, bool add) {
+    for(int i = 0; i < TERM_STREAMS; ++i) {
+        if(streams[i].file == term) return &streams[i];
+    }
+    if(!add) return NULL;
+    for(int i = 0; i < TERM_STREAMS; ++i) {
+        if(streams[i].file) continue;
+        streams[i] = (stream_t){term, TERM_COLORS_AUTO, -1, -1, false, TERM_STYLE_DEFAULT};
+        return &streams[i];
+    }
+    return NULL;
+}
+
+// MARK: - Colour support
+
+// Returns 0 or 1 when the environment decides for every stream, or -1 when it leaves it to each.
+// Threads that get here at the same time both read the environment, and agree on the answer.
+static int env_colors() {
+    static atomic_int cached = -2;
+    int colors = atomic_load_explicit(&cached, memory_order_relaxed);
+    if(colors != -2) return colors;
+
+    const char* noColor = getenv("NO_COLOR");
+    const char* force = getenv("FORCE_COLOR");
+    const char* term = getenv("TERM");
+    if(noColor && *noColor)
+        colors = 0;
+    else if(force)
+        colors = strcmp(force, "0") != 0 && strcmp(force, "false") != 0;
+    else if(term && strcmp(term, "dumb") == 0)
+        colors = 0;
+    else
+        colors = -1;
+    atomic_store_explicit(&cached, colors, memory_order_relaxed);
+    return colors;
+}
+
+static bool detect_colors(FILE* term) {
+    int colors = env_colors();
+    if(colors >= 0) return colors;
     return SUPPORTS_COLOR(term);
 }
 
-void term_set_bold(FILE* term, bool bold) {
-    if(!term_has_colors(term)) return;
-    if(bold)
-        fprintf(term, "\033[1m");
+static bool stream_colors(FILE* term, stream_t* stream) {
+    if(stream && stream->mode != TERM_COLORS_AUTO) return stream->mode == TERM_COLORS_ALWAYS;
+    // Another backend stands in for stdout, and it is a terminal.
+    if(term == stdout && hexes_get_backend() != hexes_terminal_backend()) return true;
+
+    if(!stream) return detect_colors(term);
+    if(stream->colors < 0) stream->colors = detect_colors(term);
+    return stream->colors;
+}
+
+bool term_has_colors(FILE* term) {
+    lock_streams();
+    bool colors = stream_colors(term, find_stream(term, true));
+    unlock_streams();
+    return colors;
+}
+
+void term_set_color_mode(FILE* term, term_color_mode_t mode) {
+    lock_streams();
+    stream_t* stream = find_stream(term, true);
+    if(stream) {
+        stream->mode = mode;
+        stream->colors = -1;
+        stream->known = false;
+    }
+    unlock_streams();
+}
+
+// MARK: - Palettes
+
+// xterm's default colours, which most terminals start from.
+static const uint8_t ansiColors[16][3] = {
+    {0, 0, 0}, {205, 0, 0}, {0, 205, 0}, {205, 205, 0},
+    {0, 0, 238}, {205, 0, 205}, {0, 205, 205}, {229, 229, 229},
+    {127, 127, 127}, {255, 0, 0}, {0, 255, 0}, {255, 255, 0},
+    {92, 92, 255}, {255, 0, 255}, {0, 255, 255}, {255, 255, 255},
+};
+
+// The levels each channel takes in the 6x6x6 colour cube, entries 16 to 231 of the 256 colours.
+static const uint8_t cubeLevels[6] = {0, 95, 135, 175, 215, 255};
+
+// RGB colours are looked up with 5 bits per channel, which is finer than the cube is.
+#define LUT_BITS    5
+#define LUT_SIZE    (1 << (3 * LUT_BITS))
+
+enum {LUT_MISSING, LUT_BUILDING, LUT_READY};
+
+static uint8_t lut256[LUT_SIZE];    // Entries 16 to 255: the first 16 can be themed by the user.
+static uint8_t lut16[LUT_SIZE];
+static atomic_int state256 = LUT_MISSING;
+static atomic_int state16 = LUT_MISSING;
+
+static int lut_index(int r, int g, int b) {
+    int shift = 8 - LUT_BITS;
+    return (r >> shift) << (2 * LUT_BITS) | (g >> shift) << LUT_BITS | (b >> shift);
+}
+
+// Returns the middle of the colours that share [index]'s slot in the tables.
+static void lut_rgb(int index, int* r, int* g, int* b) {
+    int shift = 8 - LUT_BITS;
+    int mask = (1 << LUT_BITS) - 1;
+    int half = 1 << (shift - 1);
+    *r = ((index >> (2 * LUT_BITS)) & mask) << shift | half;
+    *g = ((index >> LUT_BITS) & mask) << shift | half;
+    *b = (index & mask) << shift | half;
+}
+
+static void palette_rgb(int index, int* r, int* g, int* b) {
+    if(index < 16) {
+        *r = ansiColors[index][0];
+        *g = ansiColors[index][1];
+        *b = ansiColors[index][2];
+    } else if(index < 232) {
+        *r = cubeLevels[(index - 16) / 36];
+        *g = cubeLevels[(index - 16) / 6 % 6];
+        *b = cubeLevels[(index - 16) % 6];
+    } else {
+        *r = *g = *b = 8 + 10 * (index - 232);
+    }
+}
+
+// Eyes are more sensitive to green than to red, and to red than to blue.
+static int distance(int r1, int g1, int b1, int r2, int g2, int b2) {
+    int r = r1 - r2, g = g1 - g2, b = b1 - b2;
+    return 2 * r * r + 4 * g * g + 3 * b * b;
+}
+
+static int cube_level(int value) {
+    return value < 48 ? 0 : value < 115 ? 1 : (value - 35) / 40;
+}
+
+// The closest colour is either the closest one in the cube or the closest grey, and each can be
+// worked out directly rather than searched for.
+static int nearest_256(int r, int g, int b) {
+    int cr = cube_level(r), cg = cube_level(g), cb = cube_level(b);
+    int average = (r + g + b) / 3;
+    int grey = average < 3 ? 0 : (average - 3) / 10 < 23 ? (average - 3) / 10 : 23;
+    int level = 8 + 10 * grey;
+
+    int cube = distance(r, g, b, cubeLevels[cr], cubeLevels[cg], cubeLevels[cb]);
+    if(cube <= distance(r, g, b, level, level, level)) return 16 + 36 * cr + 6 * cg + cb;
+    return 232 + grey;
+}
+
+static int nearest_16(int r, int g, int b) {
+    int best = 0;
+    int bestDistance = INT32_MAX;
+    for(int i = 0; i < 16; ++i) {
+        int d = distance(r, g, b, ansiColors[i][0], ansiColors[i][1], ansiColors[i][2]);
+        if(d >= bestDistance) continue;
+        best = i;
+        bestDistance = d;
+    }
+    return best;
+}
+
+// Returns the table for the 256 or the 16 colour palette, building it the first time. Only one
+// thread builds it: the others get NULL until it is ready, and work colours out directly.
+static const uint8_t* get_lut(bool wide) {
+    atomic_int* state = wide ? &state256 : &state16;
+    uint8_t* lut = wide ? lut256 : lut16;
+    int expected = atomic_load_explicit(state, memory_order_acquire);
+    if(expected == LUT_READY) return lut;
+    if(expected == LUT_BUILDING || !atomic_compare_exchange_strong(state, &expected, LUT_BUILDING))
+        return expected == LUT_READY ? lut : NULL;
+
+    for(int i = 0; i < LUT_SIZE; ++i) {
+        int r, g, b;
+        lut_rgb(i, &r, &g, &b);
+        lut[i] = wide ? nearest_256(r, g, b) : nearest_16(r, g, b);
+    }
+    atomic_store_explicit(state, LUT_READY, memory_order_release);
+    return lut;
+}
+
+// The 16 palette entries are in ANSI order, where TERM_DEFAULT sits between the normal and the
+// bright colours.
+static term_color_t ansi_color(int index) {
+    return index < 8 ? (term_color_t)index : (term_color_t)(index + 1);
+}
+
+static bool valid_color(term_color_t color) {
+    return color < TERM_INVALID_COLOR
+        || (color & ~0xff) == TERM_COLOR_INDEXED
+        || (color & ~0xffffff) == TERM_COLOR_RGB;
+}
+
+term_color_t term_color_downsample(term_color_t color, term_palette_t palette) {
+    assert(valid_color(color) && "invalid colour");
+    if(color < TERM_INVALID_COLOR || palette == TERM_PALETTE_RGB) return color;
+
+    int r, g, b;
+    if(color & TERM_COLOR_INDEXED) {
+        int index = color & 0xff;
+        if(palette == TERM_PALETTE_256) return color;
+        if(index < 16) return ansi_color(index);
+        palette_rgb(index, &r, &g, &b);
+    } else {
+        r = (color >> 16) & 0xff;
+        g = (color >> 8) & 0xff;
+        b = color & 0xff;
+    }
+
+    // Colours are looked up by the middle of their slot in the tables, so they come out the same
+    // whether or not the table is ready.
+    int index = lut_index(r, g, b);
+    const uint8_t* lut = get_lut(palette == TERM_PALETTE_256);
+    if(!lut) lut_rgb(index, &r, &g, &b);
+    if(palette == TERM_PALETTE_256)
+        return TERM_INDEXED(lut ? lut[index] : nearest_256(r, g, b));
+    return ansi_color(lut ? lut[index] : nearest_16(r, g, b));
+}
+
+static term_palette_t env_palette() {
+    static atomic_int cached = -1;
+    int palette = atomic_load_explicit(&cached, memory_order_relaxed);
+    if(palette >= 0) return palette;
+
+    const char* colorterm = getenv("COLORTERM");
+    const char* term = getenv("TERM");
+    if(colorterm && (!strcmp(colorterm, "truecolor") || !strcmp(colorterm, "24bit")))
+        palette = TERM_PALETTE_RGB;
+    else if(term && strstr(term, "256color"))
+        palette = TERM_PALETTE_256;
     else
-        fprintf(term, "\033[22m");
+        palette = TERM_PALETTE_16;
+    atomic_store_explicit(&cached, palette, memory_order_relaxed);
+    return palette;
+}
+
+static term_palette_t stream_palette(const stream_t* stream) {
+    if(stream && stream->palette >= 0) return stream->palette;
+    return env_palette();
+}
+
+term_palette_t term_palette(FILE* term) {
+    lock_streams();
+    term_palette_t palette = stream_palette(find_stream(term, false));
+    unlock_streams();
+    return palette;
+}
+
+void term_set_palette(FILE* term, term_palette_t palette) {
+    assert(palette >= TERM_PALETTE_16 && palette <= TERM_PALETTE_RGB && "invalid palette");
+    lock_streams();
+    stream_t* stream = find_stream(term, true);
+    if(stream) {
+        stream->palette = palette;
+        stream->known = false;
+    }
+    unlock_streams();
+}
+
+// MARK: - Style tracking
+
+// What the terminal shows for a style. Named colours are kept as their SGR code, and the others as
+// they are once downsampled.
+typedef struct {
+    int fg, bg;
+    bool bold, underline, reverse;
+} shown_style_t;
+
+static int shown_color(term_color_t color, const int* codes) {
+    return color < TERM_INVALID_COLOR ? codes[color] : (int)color;
+}
+
+static shown_style_t shown_style(term_style_t style, term_palette_t palette) {
+    term_color_t fg = term_color_downsample(style.fg, palette);
+    term_color_t bg = term_color_downsample(style.bg, palette);
+    return (shown_style_t){
+        .fg = shown_color(fg, _fgCodes),
+        .bg = shown_color(bg, _bgCodes),
+        .bold = style.bold,
+        .underline = style.underline,
+        .reverse = style.reverse,
+    };
+}
+
+// Writes the parameters that select [color], as shown_style() keeps it. [extended] is the code
+// that introduces 256 and 24-bit colours: 38 for the foreground, 48 for the background.
+static int put_color(int* params, int color, int extended) {
+    if(color & TERM_COLOR_INDEXED) {
+        params[0] = extended;
+        params[1] = 5;
+        params[2] = color & 0xff;
+        return 3;
+    }
+    if(color & TERM_COLOR_RGB) {
+        params[0] = extended;
+        params[1] = 2;
+        params[2] = (color >> 16) & 0xff;
+        params[3] = (color >> 8) & 0xff;
+        params[4] = color & 0xff;
+        return 5;
+    }
+    params[0] = color;
+    return 1;
+}
+
+int style_encode(char* buffer, term_palette_t palette, const term_style_t* from, term_style_t to) {
+    shown_style_t next = shown_style(to, palette);
+    shown_style_t shown = shown_style(from ? *from : TERM_STYLE_DEFAULT, palette);
+    int params[CSI_MAX_PARAMS];
+    int count = 0;
+
+    // We turn attributes off by starting from a clean slate: the codes that turn them off one by
+    // one aren't known everywhere.
+    if(!from || (shown.bold && !next.bold) || (shown.underline && !next.underline)
+       || (shown.reverse && !next.reverse)) {
+        params[count++] = 0;
+        shown = shown_style(TERM_STYLE_DEFAULT, palette);
+    }
+
+    if(next.bold && !shown.bold) params[count++] = 1;
+    if(next.underline && !shown.underline) params[count++] = 4;
+    if(next.reverse && !shown.reverse) params[count++] = 7;
+    if(next.fg != shown.fg) count += put_color(params + count, next.fg, 38);
+    if(next.bg != shown.bg) count += put_color(params + count, next.bg, 48);
+    return count ? csi_encode(buffer, params, count, 'm') : 0;
+}
+
+int style_change(char* buffer, term_palette_t palette, const term_style_t* from, term_style_t to) {
+    int length = style_encode(buffer, palette, from, to);
+    if(length) STATS_ESCAPE(TERM_ESCAPE_SGR);
+    return length;
+}
+
+void style_assume(FILE* term, term_style_t style) {
+    lock_streams();
+    stream_t* stream = find_stream(term, true);
+    if(stream) {
+        stream->known = true;
+        stream->style = style;
+    }
+    unlock_streams();
+}
+
+bool style_is_default(FILE* term) {
+    lock_streams();
+    stream_t* stream = find_stream(term, false);
+    const term_style_t* style = stream && stream->known ? &stream->style : NULL;
+    bool clean = style && style->fg == TERM_DEFAULT && style->bg == TERM_DEFAULT && !style->bold
+        && !style->underline && !style->reverse;
+    unlock_streams();
+    return clean;
+}
+
+void term_set_style(FILE* term, term_style_t style) {
+    char buffer[CSI_MAX_LENGTH];
+    lock_streams();
+    stream_t* stream = find_stream(term, true);
+    if(!stream_colors(term, stream)) {
+        unlock_streams();
+        return;
+    }
+    const term_style_t* from = stream && stream->known ? &stream->style : NULL;
+    int length = style_change(buffer, stream_palette(stream), from, style);
+    if(stream) {
+        stream->known = true;
+        stream->style = style;
+    }
+    unlock_streams();
+    if(length) style_write(term, buffer, length);
+}
+
+term_style_t term_get_style(FILE* term) {
+    lock_streams();
+    stream_t* stream = find_stream(term, false);
+    term_style_t style = stream ? stream->style : TERM_STYLE_DEFAULT;
+    unlock_streams();
+    return style;
+}
+
+void term_style_invalidate(FILE* term) {
+    lock_streams();
+    stream_t* stream = find_stream(term, false);
+    if(stream) stream->known = false;
+    unlock_streams();
+}
+
+// MARK: - Attributes
+
+void term_set_bold(FILE* term, bool bold) {
+    term_style_t style = term_get_style(term);
+    style.bold = bold;
+    term_set_style(term, style);
 }
 
 void term_set_underline(FILE* term, bool underline) {
-    if(!term_has_colors(term)) return;
-    if(underline)
-        fprintf(term, "\033[4m");
-    else
-        fprintf(term, "\033[24m");
+    term_style_t style = term_get_style(term);
+    style.underline = underline;
+    term_set_style(term, style);
 }
 
 void term_set_fg(FILE* term, term_color_t color) {
-    if(!term_has_colors(term)) return;
-    assert(color >= TERM_BLACK && color < TERM_INVALID_COLOR);
-    fprintf(term, "%s", _fgColors[color]);
+    assert(valid_color(color) && "invalid colour");
+    term_style_t style = term_get_style(term);
+    style.fg = color;
+    term_set_style(term, style);
 }
 
 void term_set_bg(FILE* term, term_color_t color) {
-    if(!term_has_colors(term)) return;
-    assert(color >= TERM_BLACK && color < TERM_INVALID_COLOR);
-    fprintf(term, "%s", _bgColors[color]);
+    assert(valid_color(color) && "invalid colour");
+    term_style_t style = term_get_style(term);
+    style.bg = color;
+    term_set_style(term, style);
 }
 
 void term_reverse(FILE* term) {
-    if(!term_has_colors(term)) return;
-    fprintf(term, "\033[7m");
+    term_style_t style = term_get_style(term);
+    style.reverse = true;
+    term_set_style(term, style);
 }
 
 void term_style_reset(FILE* term) {
-    if(!term_has_colors(term)) return;
-    fprintf(term, "\033[0m");
+    term_set_style(term, TERM_STYLE_DEFAULT);
 }
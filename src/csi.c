@@ -0,0 +1,99 @@
+//===--------------------------------------------------------------------------------------------===
+// csi.c - printf-free encoder for control sequences
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#include "csi.h"
+#include "instrument.h"
+#include <assert.h>
+#include <string.h>
+
+static const char digitPairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+int csi_uint(char* buffer, unsigned value) {
+    // Almost every parameter we send is a coordinate or a colour code, so one- and two-digit
+    // numbers get their own paths.
+    if(value < 10) {
+        buffer[0] = '0' + value;
+        return 1;
+    }
+    if(value < 100) {
+        memcpy(buffer, &digitPairs[value * 2], 2);
+        return 2;
+    }
+
+    char scratch[10];
+    int length = 0;
+    while(value >= 100) {
+        unsigned pair = value % 100;
+        value /= 100;
+        scratch[sizeof(scratch) - 1 - length++] = digitPairs[pair * 2 + 1];
+        scratch[sizeof(scratch) - 1 - length++] = digitPairs[pair * 2];
+    }
+    if(value >= 10) {
+        scratch[sizeof(scratch) - 1 - length++] = digitPairs[value * 2 + 1];
+        scratch[sizeof(scratch) - 1 - length++] = digitPairs[value * 2];
+    } else {
+        scratch[sizeof(scratch) - 1 - length++] = '0' + value;
+    }
+    memcpy(buffer, scratch + sizeof(scratch) - length, length);
+    return length;
+}
+
+int csi_sequence(char* buffer, const int* params, int count, char final) {
+    STATS_CSI(final);
+    return csi_encode(buffer, params, count, final);
+}
+
+int csi_encode(char* buffer, const int* params, int count, char final) {
+    assert(count <= CSI_MAX_PARAMS && "too many control sequence parameters");
+    int length = 0;
+    buffer[length++] = '\033';
+    buffer[length++] = '[';
+    for(int i = 0; i < count; ++i) {
+        if(i) buffer[length++] = ';';
+        if(params[i] >= 0) length += csi_uint(buffer + length, params[i]);
+    }
+    buffer[length++] = final;
+    return length;
+}
+
+int csi_cursor_go(char* buffer, int x, int y) {
+    STATS_ESCAPE(TERM_ESCAPE_CURSOR);
+    int length = 0;
+    buffer[length++] = '\033';
+    buffer[length++] = '[';
+    length += csi_uint(buffer + length, y + 1);
+    buffer[length++] = ';';
+    length += csi_uint(buffer + length, x + 1);
+    buffer[length++] = 'H';
+    return length;
+}
+
+int csi_cursor_move(char* buffer, int n, char direction) {
+    STATS_ESCAPE(TERM_ESCAPE_CURSOR);
+    int length = 0;
+    buffer[length++] = '\033';
+    buffer[length++] = '[';
+    if(n != 1) length += csi_uint(buffer + length, n);
+    buffer[length++] = direction;
+    return length;
+}
+
+int csi_sgr(char* buffer, const int* params, int count) {
+    return csi_sequence(buffer, params, count, 'm');
+}
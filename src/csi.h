@@ -0,0 +1,36 @@
+//===--------------------------------------------------------------------------------------------===
+// csi.h - printf-free encoder for control sequences
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef term_csi_h
+#define term_csi_h
+
+// All encoders write into a caller-provided buffer, which must have room for at least
+// CSI_MAX_LENGTH bytes, and return the number of bytes written. Nothing is null-terminated.
+#define CSI_MAX_PARAMS 16
+// ESC, [ and the final byte, then each parameter: up to 10 digits and a separator.
+#define CSI_MAX_LENGTH (3 + CSI_MAX_PARAMS * 11)
+
+/// Writes the decimal representation of [value].
+int csi_uint(char* buffer, unsigned value);
+
+/// Writes "ESC [ p1 ; p2 ; ... final". Negative parameters are left empty.
+int csi_sequence(char* buffer, const int* params, int count, char final);
+/// Like csi_sequence(), without counting the sequence in the stats: for sequences that are kept to
+/// be sent later, and counted then.
+int csi_encode(char* buffer, const int* params, int count, char final);
+
+/// Writes the sequence to move the cursor to (x, y), 0-based.
+int csi_cursor_go(char* buffer, int x, int y);
+/// Writes the sequence to move the cursor [n] cells in [direction] ('A', 'B', 'C' or 'D'). [n] must
+/// be positive: terminals read 0 as 1.
+int csi_cursor_move(char* buffer, int n, char direction);
+/// Writes "ESC [ p1 ; ... m". With no parameters, this is a style reset.
+int csi_sgr(char* buffer, const int* params, int count);
+
+#endif
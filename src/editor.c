@@ -10,6 +10,8 @@
 #include <term/editor.h>
 #include <term/colors.h>
 #include <term/hexes.h>
+#include <term/screen.h>
+#include "instrument.h"
 #include "string_buf.h"
 #include <stdio.h>
 #include <string.h>
@@ -38,6 +40,7 @@ typedef struct Editor {
 
     Coords cursor;
     Coords offset;
+    int renderedOffset;     // The vertical offset the screen was last rendered with.
 
     int lineCount;
     int lineCapacity;
@@ -46,6 +49,7 @@ typedef struct Editor {
     Token highlight;
     
     string_buf_t buffer;
+    hexes_screen_t* screen;
 
     const char* status;
     char* message;
@@ -53,6 +57,7 @@ typedef struct Editor {
 static Editor E;
 
 static inline int min(int a, int b) { return a < b ? a : b; }
+static inline int max(int a, int b) { return a > b ? a : b; }
 
 static void ensureLines(int count) {
     if(count <= E.lineCapacity) return;
@@ -164,6 +169,47 @@ static void editorNewline() {
     E.offset.x = 0;
 }
 
+// Inserts a block of text at the cursor with a single buffer operation, then rebuilds the line
+// table from the cursor's line onwards and moves the cursor to the end of the new text.
+static void editorInsertText(const char* text, int length) {
+    int x = E.offset.x + E.cursor.x;
+    int y = E.offset.y + E.cursor.y;
+    int offset = E.lines[y].offset + x;
+    string_buf_insert_n(&E.buffer, offset, text, length);
+
+    int lineCount = y;
+    int start = E.lines[y].offset;
+    for(int i = start; i <= E.buffer.count; ++i) {
+        if(i < E.buffer.count && E.buffer.data[i] != '\n') continue;
+        ensureLines(lineCount + 1);
+        E.lines[lineCount++] = (EditorLine){.offset = start, .count = i - start};
+        start = i + 1;
+    }
+    E.lineCount = lineCount;
+
+    int end = offset + length;
+    int line = y;
+    while(line < E.lineCount - 1 && end > E.lines[line].offset + E.lines[line].count) line += 1;
+    E.cursor.y = line - E.offset.y;
+    E.cursor.x = end - E.lines[line].offset - E.offset.x;
+}
+
+// Terminals send pasted line breaks as carriage returns, which we store as newlines.
+static void editorPaste(const char* text, int length) {
+    char* normalised = malloc(length);
+    int count = 0;
+    for(int i = 0; i < length; ++i) {
+        if(text[i] == '\r') {
+            normalised[count++] = '\n';
+            if(i + 1 < length && text[i + 1] == '\n') i += 1;
+        } else {
+            normalised[count++] = text[i];
+        }
+    }
+    editorInsertText(normalised, count);
+    free(normalised);
+}
+
 // MARK: - "public" API
 
 void termEditorInit(const char* title) {
@@ -185,18 +231,30 @@ void termEditorInit(const char* title) {
     E.message[0] = '\0';
     E.highlight = (Token){-1, -1, -1};
 
+    int nx = 0, ny = 0;
+    hexes_get_size(&nx, &ny);
+    E.screen = hexes_screen_new(nx, ny);
+    E.renderedOffset = 0;
+
     hexes_raw_start();
     hexes_set_alternate(true);
+    hexes_set_bracketed_paste(true);
+    hexes_set_mouse(HEXES_MOUSE_CLICKS);
 }
 
 void termEditorDeinit() {
+    hexes_schedule_render(NULL, NULL);
+    hexes_set_mouse(HEXES_MOUSE_OFF);
+    hexes_set_bracketed_paste(false);
     hexes_raw_stop();
     hexes_set_alternate(false);
     string_buf_fini(&E.buffer);
     
     if(E.lines) free(E.lines);
     if(E.message) free(E.message);
+    if(E.screen) hexes_screen_destroy(E.screen);
     E.lines = NULL;
+    E.screen = NULL;
     E.lineCount = E.lineCapacity = 0;
     
     E.title = "";
@@ -218,10 +276,18 @@ const char* termEditorBuffer(int* length) {
     return E.buffer.data;
 }
 
+// The line number gutter: at least three digits, then a space.
+static int gutterWidth() {
+    int digits = 3;
+    for(int count = E.lineCount; count >= 1000; count /= 10) digits += 1;
+    return digits + 1;
+}
+
 static void keepInView() {
+    TRACE_BEGIN("keepInView");
     int nx = 0, ny = 0;
-    assert(hexes_get_size(&nx, &ny) == 0);
-    nx -= 5; // To account for the line number space
+    hexes_get_size(&nx, &ny);
+    nx -= gutterWidth() + 1; // To account for the line number space
     ny -= 3; // To account for the status bar
 
     if(E.cursor.x > nx) {
@@ -241,16 +307,12 @@ static void keepInView() {
         E.offset.y -= dist;
         E.cursor.y = 0;
     }
+    TRACE_END("keepInView");
 }
 
-// TODO: this isn't really the nicest way to do things, we could probably memcpy a lot of this.
 void termEditorReplace(const char* data) {
     termEditorClear();
-    while(*data) {
-        char c = *data++;
-        if(c == '\n') editorNewline();
-        else editorInsert(c);
-    }
+    editorInsertText(data, strlen(data));
     E.cursor.x = 0;
     E.cursor.y = 0;
     E.offset.x = 0;
@@ -271,6 +333,12 @@ void termEditorClear() {
     E.lineCount = 1;
 }
 
+static const hexes_style_t gutterStyle = HEXES_STYLE(TERM_BLUE, TERM_DEFAULT, 0);
+static const hexes_style_t titleStyle = HEXES_STYLE(TERM_BLUE, TERM_DEFAULT, HEXES_ATTR_REVERSE);
+static const hexes_style_t messageStyle = HEXES_STYLE(TERM_DEFAULT, TERM_DEFAULT, HEXES_ATTR_BOLD);
+static const hexes_style_t highlightStyle = HEXES_STYLE(TERM_RED, TERM_DEFAULT,
+                                                        HEXES_ATTR_BOLD | HEXES_ATTR_UNDERLINE);
+
 static void renderTitle(int nx, int ny) {
 
     int c = E.cursor.x + E.offset.x + 1, r= E.cursor.y + E.offset.y + 1;
@@ -278,87 +346,97 @@ static void renderTitle(int nx, int ny) {
     char locBuffer[16];
     int locLength = snprintf(locBuffer, 16, " (%d, %d)  ", c, r);
 
-    term_set_fg(stdout, TERM_BLUE);
-    hexes_cursor_go(0, ny-2);
-    term_reverse(stdout);
-    int titleLength = printf("  %s | ", E.title);
-
+    hexes_screen_fill(E.screen, 0, ny-2, nx, ' ', titleStyle);
+    int titleLength = snprintf(NULL, 0, "  %s | ", E.title);
+    char title[titleLength + 1];
+    snprintf(title, titleLength + 1, "  %s | ", E.title);
+    hexes_screen_print(E.screen, 0, ny-2, title, titleLength, titleStyle);
 
     int statusLength = E.status ? min(nx - (titleLength + locLength), (int)strlen(E.status)) : 0;
-    int locPad = nx - (titleLength + statusLength);
-    printf("%.*s%*s", statusLength, E.status ? E.status : "", locPad, locBuffer);
-    term_style_reset(stdout);
+    if(statusLength > 0)
+        hexes_screen_print(E.screen, titleLength, ny-2, E.status, statusLength, titleStyle);
+    hexes_screen_print(E.screen, nx - locLength, ny-2, locBuffer, locLength, titleStyle);
 }
 
 static void renderMessage(int nx, int ny) {
     int length = strlen(E.message);
     if(!length) return;
-    hexes_cursor_go(0, ny-1);
-    term_set_bold(stdout, true);
-    printf("> %.*s", min(nx - 2, strlen(E.message)), E.message);
-    term_style_reset(stdout);
+    hexes_screen_print(E.screen, 0, ny-1, "> ", 2, messageStyle);
+    hexes_screen_print(E.screen, 2, ny-1, E.message, min(nx - 2, length), messageStyle);
 }
 
-static bool renderLineHead(int l) {
-    bool done = false;
-    term_set_fg(stdout, TERM_BLUE);
+static bool renderLineHead(int i, int l) {
+    int width = gutterWidth();
     if(l < E.lineCount) {
-        printf("%3d ", l + 1);
-        done = false;
-    } else {
-        printf("  ~ ");
-        done = true;
+        char head[16];
+        snprintf(head, sizeof(head), "%*d ", width - 1, l + 1);
+        hexes_screen_print(E.screen, 0, i, head, width, gutterStyle);
+        return false;
     }
-    term_set_fg(stdout, TERM_DEFAULT);
-    return done;
+    hexes_screen_fill(E.screen, 0, i, width, ' ', gutterStyle);
+    hexes_screen_put(E.screen, width - 2, i, '~', gutterStyle);
+    return true;
 }
 
 static void renderLine(int i, int nx, int ny) {
-    hexes_cursor_go(0, i);
-    hexes_clear_line();
     int index = i + E.offset.y;
-    if(renderLineHead(index)) return;
+    if(renderLineHead(i, index)) return;
     EditorLine line = E.lines[index];
 
     if(!line.count || line.count <= E.offset.x) return;
 
     int startHL = (E.highlight.column - 1);
     int endHL = (E.highlight.column + E.highlight.length - 1);
+    bool highlightLine = index == E.highlight.line-1;
 
-    for(int i = 0; i < nx - 4; ++i) {
-        int idx = i + E.offset.x;
+    int gutter = gutterWidth();
+    for(int col = 0; col < nx - gutter; ++col) {
+        int idx = col + E.offset.x;
         if(idx == line.count) break;
-        if(idx == startHL && index == E.highlight.line-1) {
-            term_set_underline(stdout, true);
-            term_set_bold(stdout, true);
-            term_set_fg(stdout, TERM_RED);
-        }
-        putchar(E.buffer.data[line.offset + idx]);
-        if(idx == endHL && index == E.highlight.line-1) {
-            term_style_reset(stdout);
-        }
+        bool highlighted = highlightLine && idx >= startHL && idx <= endHL;
+        hexes_screen_put(E.screen, gutter + col, i, E.buffer.data[line.offset + idx],
+                         highlighted ? highlightStyle : HEXES_STYLE_DEFAULT);
     }
-
-    term_style_reset(stdout);
-
 }
 
-void termEditorRender() {
+static void render(void* data) {
+    (void)data;
+    TRACE_BEGIN("termEditorRender");
     int nx = 0, ny = 0;
-    assert(hexes_get_size(&nx, &ny) == 0);
-    hexes_cursor_go(0, 0);
-
-    Coords screen = (Coords){
-        E.cursor.x + 4,
-        E.cursor.y
-    };
-
-    for(int i = 0; i < ny-2; ++i) renderLine(i, nx, ny);
+    hexes_get_size(&nx, &ny);
+    if(nx != hexes_screen_width(E.screen) || ny != hexes_screen_height(E.screen))
+        hexes_screen_resize(E.screen, nx, ny);
+    hexes_screen_clear(E.screen);
+
+    // When the text moved by a few lines, the terminal can shift what it already shows, and we only
+    // draw the lines that came into view. Beyond half the text area, just redraw it.
+    int scroll = E.offset.y - E.renderedOffset;
+    if(scroll && abs(scroll) <= (ny - 2) / 2) hexes_screen_scroll(E.screen, 0, ny - 2, scroll);
+    E.renderedOffset = E.offset.y;
+
+    for(int i = 0; i < ny-2; ++i) {
+        TRACE_BEGIN("renderLine");
+        renderLine(i, nx, ny);
+        TRACE_END("renderLine");
+    }
     renderTitle(nx, ny);
     renderMessage(nx, ny);
 
-    hexes_cursor_go(screen.x, screen.y);
-    fflush(stdout);
+    hexes_screen_cursor(E.screen, E.cursor.x + gutterWidth(), E.cursor.y);
+    hexes_screen_present(E.screen);
+    latency_presented(HEXES_LATENCY_EDITOR);
+    TRACE_END("termEditorRender");
+}
+
+void termEditorRender() {
+    // With more input already waiting, or before the frame interval is up, drawing now would be
+    // wasted: the event loop draws once it runs out of input instead.
+    if(hexes_pending_events() || hexes_frame_delay()) {
+        hexes_schedule_render(render, NULL);
+        return;
+    }
+    hexes_schedule_render(NULL, NULL);
+    render(NULL);
 }
 
 void termEditorLeft() {
@@ -399,8 +477,58 @@ void termEditorInsert(char c) {
     editorInsert(c);
 }
 
-HexesKey termEditorUpdate() {
-    int c = hexes_get_key_raw();
+// MARK: - Mouse
+
+// Puts the cursor on the character under a left click in the text area.
+static void editorClick(int x, int y) {
+    int nx = 0, ny = 0;
+    hexes_get_size(&nx, &ny);
+    int gutter = gutterWidth();
+    if(y > ny - 3 || x < gutter) return;
+
+    int line = min(E.offset.y + y, E.lineCount - 1);
+    E.cursor.y = line - E.offset.y;
+    E.cursor.x = min(E.offset.x + x - gutter, E.lines[line].count) - E.offset.x;
+}
+
+// Scrolls the text by [dy] lines, keeping the cursor on the same line while it stays in view.
+// A burst of wheel turns arrives as one event, so this scrolls (and renders) once per burst.
+static void editorScroll(int dy) {
+    int nx = 0, ny = 0;
+    hexes_get_size(&nx, &ny);
+    int rows = ny - 2;
+
+    int line = E.offset.y + E.cursor.y;
+    E.offset.y = max(0, min(E.offset.y + dy, E.lineCount - rows));
+    line = max(E.offset.y, min(line, E.offset.y + rows - 1));
+    line = min(line, E.lineCount - 1);
+    E.cursor.y = line - E.offset.y;
+
+    int column = min(E.offset.x + E.cursor.x, E.lines[line].count);
+    E.cursor.x = column - E.offset.x;
+}
+
+static HexesKey handle(const hexes_event_t* event) {
+    if(event->kind == HEXES_EVENT_RESIZE) {
+        keepInView();
+        termEditorRender();
+        return -1;
+    }
+    if(event->kind == HEXES_EVENT_MOUSE) {
+        if(event->action == HEXES_MOUSE_PRESS && event->button == HEXES_BUTTON_LEFT)
+            editorClick(event->x, event->y);
+        else if(event->action == HEXES_MOUSE_WHEEL && event->dy)
+            editorScroll(event->dy);
+        else
+            return -1;
+        keepInView();
+        termEditorRender();
+        return -1;
+    }
+    if(event->kind != HEXES_EVENT_KEY && event->kind != HEXES_EVENT_PASTE) return -1;
+    if(event->mods & HEXES_MOD_ALT) return -1; // Nothing is bound to Alt: don't type Alt+b as b
+
+    int c = event->key;
     switch(c) {
     case KEY_RETURN:
         editorNewline();
@@ -432,6 +560,10 @@ HexesKey termEditorUpdate() {
         termEditorLeft();
         break;
 
+    case KEY_PASTE:
+        if(event->text && event->length) editorPaste(event->text, event->length);
+        break;
+
     case KEY_CTRL_D:
     case KEY_TAB:
     case KEY_CTRL_C:
@@ -440,9 +572,26 @@ HexesKey termEditorUpdate() {
         break;
 
     default:
-        editorInsert(c);
+        if(c >= 0 && c <= 0xff) editorInsert(c);
         break;
     }
     keepInView();
     return c;
 }
+
+HexesKey termEditorHandle(const hexes_event_t* event) {
+    TRACE_BEGIN("termEditorHandle");
+    HexesKey key = handle(event);
+    TRACE_END("termEditorHandle");
+    return key;
+}
+
+HexesKey termEditorUpdate() {
+    hexes_event_t event;
+    for(;;) {
+        if(hexes_poll_event(&event, -1) < 0) return -1;
+        if(event.kind == HEXES_EVENT_KEY || event.kind == HEXES_EVENT_PASTE)
+            return termEditorHandle(&event);
+        termEditorHandle(&event);
+    }
+}
@@ -0,0 +1,342 @@
+//===--------------------------------------------------------------------------------------------===
+// event.c - poll()-based event loop for hexes programs
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#include <term/hexes.h>
+#include <term/backend.h>
+#include "input.h"
+#include "recorder.h"
+#include "resize.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// MARK: - Render scheduling
+// Programs draw in response to input, and input comes in bursts: when a key is held down, or
+// text is typed faster than we read it. Rather than drawing after every event, they schedule a
+// render, and the loop runs it once, when it runs out of events to hand out.
+
+static struct {
+    void (*render)(void*);
+    void* data;
+} scheduled = {NULL, NULL};
+
+void hexes_flush_render() {
+    if(!scheduled.render) return;
+    void (*render)(void*) = scheduled.render;
+    scheduled.render = NULL;
+    render(scheduled.data);
+}
+
+void hexes_schedule_render(void (*render)(void*), void* data) {
+    bool replaced = scheduled.render && (scheduled.render != render || scheduled.data != data);
+    if(render && replaced) hexes_flush_render();
+    scheduled.render = render;
+    scheduled.data = data;
+}
+
+#ifndef _WIN32
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+// How often we look for input from backends that have no file descriptor to poll, in milliseconds.
+#define LOOP_INPUT_INTERVAL 10
+
+typedef struct {
+    int id;
+    int64_t due;
+    int interval;
+    bool repeat;
+} loop_timer_t;
+
+typedef struct {
+    int fd;
+    int flags;
+    int ready;
+    void* data;
+} watch_t;
+
+static struct {
+    loop_timer_t* timers;
+    int timerCount;
+    int timerCapacity;
+    int nextTimerId;
+
+    watch_t* watches;
+    int watchCount;
+    int watchCapacity;
+
+    struct pollfd* fds;
+    int fdCapacity;
+
+    int resizeFd;
+    bool resizePending;
+    int width, height;
+
+    int64_t escapeDeadline;
+} loop = {
+    .timers = NULL,
+    .timerCount = 0,
+    .timerCapacity = 0,
+    .nextTimerId = 1,
+    .watches = NULL,
+    .watchCount = 0,
+    .watchCapacity = 0,
+    .fds = NULL,
+    .fdCapacity = 0,
+    .resizeFd = -1,
+    .resizePending = false,
+    .width = -1,
+    .height = -1,
+    .escapeDeadline = -1,
+};
+
+static int64_t now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// MARK: - Timers
+
+int hexes_add_timer(int interval, bool repeat) {
+    assert(interval >= 0 && "timer interval cannot be negative");
+    if(loop.timerCount == loop.timerCapacity) {
+        loop.timerCapacity = loop.timerCapacity ? loop.timerCapacity * 2 : 8;
+        loop.timers = realloc(loop.timers, loop.timerCapacity * sizeof(loop_timer_t));
+    }
+    int id = loop.nextTimerId++;
+    loop.timers[loop.timerCount++] = (loop_timer_t){
+        .id = id,
+        .due = now_ms() + interval,
+        .interval = interval,
+        .repeat = repeat
+    };
+    return id;
+}
+
+void hexes_remove_timer(int id) {
+    for(int i = 0; i < loop.timerCount; ++i) {
+        if(loop.timers[i].id != id) continue;
+        loop.timers[i] = loop.timers[--loop.timerCount];
+        return;
+    }
+}
+
+static loop_timer_t* next_timer() {
+    loop_timer_t* next = NULL;
+    for(int i = 0; i < loop.timerCount; ++i) {
+        if(!next || loop.timers[i].due < next->due) next = &loop.timers[i];
+    }
+    return next;
+}
+
+static bool fire_timer(hexes_event_t* event, int64_t now) {
+    loop_timer_t* timer = next_timer();
+    if(!timer || timer->due > now) return false;
+
+    *event = (hexes_event_t){.kind = HEXES_EVENT_TIMER, .id = timer->id};
+    if(timer->repeat) {
+        // Skip the ticks we missed rather than firing them all in a row.
+        timer->due += timer->interval;
+        if(timer->due <= now) timer->due = now + timer->interval;
+    } else {
+        hexes_remove_timer(timer->id);
+    }
+    return true;
+}
+
+// MARK: - Watched file descriptors
+
+void hexes_watch_fd(int fd, int flags, void* data) {
+    for(int i = 0; i < loop.watchCount; ++i) {
+        if(loop.watches[i].fd != fd) continue;
+        loop.watches[i].flags = flags;
+        loop.watches[i].data = data;
+        return;
+    }
+    if(loop.watchCount == loop.watchCapacity) {
+        loop.watchCapacity = loop.watchCapacity ? loop.watchCapacity * 2 : 8;
+        loop.watches = realloc(loop.watches, loop.watchCapacity * sizeof(watch_t));
+    }
+    loop.watches[loop.watchCount++] = (watch_t){.fd = fd, .flags = flags, .ready = 0, .data = data};
+}
+
+void hexes_unwatch_fd(int fd) {
+    for(int i = 0; i < loop.watchCount; ++i) {
+        if(loop.watches[i].fd != fd) continue;
+        loop.watches[i] = loop.watches[--loop.watchCount];
+        return;
+    }
+}
+
+static bool ready_fd(hexes_event_t* event) {
+    for(int i = 0; i < loop.watchCount; ++i) {
+        watch_t* watch = &loop.watches[i];
+        if(!watch->ready) continue;
+        *event = (hexes_event_t){
+            .kind = HEXES_EVENT_FD,
+            .id = watch->fd,
+            .ready = watch->ready,
+            .data = watch->data
+        };
+        watch->ready = 0;
+        return true;
+    }
+    return false;
+}
+
+// MARK: - Polling
+
+static inline int64_t max64(int64_t a, int64_t b) {
+    return a > b ? a : b;
+}
+
+// Waits are in milliseconds, with -1 meaning forever.
+static inline int64_t min_wait(int64_t wait, int64_t other) {
+    return wait < 0 || other < wait ? other : wait;
+}
+
+static int poll_flags(int flags) {
+    return (flags & HEXES_FD_READ ? POLLIN : 0) | (flags & HEXES_FD_WRITE ? POLLOUT : 0);
+}
+
+static int ready_flags(int revents) {
+    return (revents & POLLIN ? HEXES_FD_READ : 0)
+        | (revents & POLLOUT ? HEXES_FD_WRITE : 0)
+        | (revents & (POLLERR | POLLHUP | POLLNVAL) ? HEXES_FD_ERROR : 0);
+}
+
+// Returns the next event we already know about, without waiting.
+static bool next_event(hexes_event_t* event) {
+    if(input_ready()) return input_pop(event);
+
+    if(loop.resizePending) {
+        // Only report sizes that actually changed: SIGWINCH can come without one.
+        loop.resizePending = false;
+        int width = 0, height = 0;
+        if(hexes_get_size(&width, &height) == 0 && (width != loop.width || height != loop.height)) {
+            loop.width = width;
+            loop.height = height;
+            record_resize(width, height);
+            *event = (hexes_event_t){.kind = HEXES_EVENT_RESIZE, .width = width, .height = height};
+            return true;
+        }
+    }
+
+    if(fire_timer(event, now_ms())) return true;
+    return ready_fd(event);
+}
+
+int hexes_poll_event(hexes_event_t* event, int timeout) {
+    assert(event && "cannot poll an event into a null pointer");
+    const hexes_backend_t* backend = hexes_get_backend();
+    bool terminal = backend == hexes_terminal_backend();
+    if(loop.width < 0) hexes_get_size(&loop.width, &loop.height);
+    if(terminal && loop.resizeFd < 0) loop.resizeFd = resize_watch();
+    int64_t deadline = timeout >= 0 ? now_ms() + timeout : -1;
+
+    for(;;) {
+        // Other backends don't signal resizes: we compare sizes every time around instead.
+        if(!terminal) loop.resizePending = true;
+        if(backend->inputFd < 0 && !input_closed()) input_read(0);
+        if(next_event(event)) return 1;
+        if(input_closed() && !input_waiting()) return -1;
+
+        // Work out how long we can sleep: until the caller's deadline, the next timer, or the point
+        // where a lone ESC stops looking like the start of a sequence.
+        int64_t now = now_ms();
+        int64_t wait = deadline >= 0 ? max64(deadline - now, 0) : -1;
+
+        loop_timer_t* timer = next_timer();
+        if(timer) wait = min_wait(wait, max64(timer->due - now, 0));
+
+        // We're out of events: this is where a scheduled render happens, unless the frame
+        // interval says it's too early, in which case we wake up when it isn't.
+        if(scheduled.render && !input_waiting()) {
+            int delay = hexes_frame_delay();
+            if(!delay) {
+                hexes_flush_render();
+                continue;
+            }
+            wait = min_wait(wait, delay);
+        }
+
+        if(!input_waiting()) {
+            loop.escapeDeadline = -1;
+        } else {
+            if(loop.escapeDeadline < 0) loop.escapeDeadline = now + INPUT_ESC_TIMEOUT;
+            wait = min_wait(wait, max64(loop.escapeDeadline - now, 0));
+        }
+
+        if(backend->inputFd < 0 && !input_closed())
+            wait = min_wait(wait, LOOP_INPUT_INTERVAL);
+
+        int count = 2 + loop.watchCount;
+        if(count > loop.fdCapacity) {
+            loop.fdCapacity = count * 2;
+            loop.fds = realloc(loop.fds, loop.fdCapacity * sizeof(struct pollfd));
+        }
+        loop.fds[0] = (struct pollfd){input_closed() ? -1 : backend->inputFd, POLLIN, 0};
+        loop.fds[1] = (struct pollfd){terminal ? loop.resizeFd : -1, POLLIN, 0};
+        for(int i = 0; i < loop.watchCount; ++i) {
+            loop.fds[2 + i] = (struct pollfd){
+                loop.watches[i].fd,
+                poll_flags(loop.watches[i].flags),
+                0
+            };
+        }
+
+        int ready = poll(loop.fds, count, wait < 0 ? -1 : (int)wait);
+        if(ready < 0) {
+            if(errno == EINTR) continue;
+            return -1;
+        }
+
+        if(loop.fds[0].revents) input_read(-1);
+        if(loop.fds[1].revents & POLLIN) {
+            resize_drain();
+            loop.resizePending = true;
+        }
+        for(int i = 0; i < loop.watchCount; ++i) {
+            loop.watches[i].ready |= ready_flags(loop.fds[2 + i].revents);
+        }
+
+        now = now_ms();
+        if(loop.escapeDeadline >= 0 && now >= loop.escapeDeadline && input_waiting()) {
+            input_timeout();
+            loop.escapeDeadline = -1;
+        }
+        if(deadline >= 0 && now >= deadline) return next_event(event) ? 1 : 0;
+    }
+}
+
+#else
+
+int hexes_poll_event(hexes_event_t* event, int timeout) {
+    (void)timeout;
+    if(!hexes_pending_events()) hexes_flush_render();
+    return hexes_next_event(event) ? 1 : -1;
+}
+
+int hexes_add_timer(int interval, bool repeat) {
+    return -1;
+}
+
+void hexes_remove_timer(int id) {
+}
+
+void hexes_watch_fd(int fd, int flags, void* data) {
+}
+
+void hexes_unwatch_fd(int fd) {
+}
+
+#endif
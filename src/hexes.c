@@ -8,7 +8,20 @@
 // =^•.•^=
 //===--------------------------------------------------------------------------------------------===
 #include <term/hexes.h>
-#include <ctype.h>
+#include <term/backend.h>
+#include <term/colors.h>
+#include <term/record.h>
+#include "csi.h"
+#include "input.h"
+#include "instrument.h"
+#include "recorder.h"
+#include "resize.h"
+#include "string_buf.h"
+#include <assert.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 
 #ifdef _WIN32
 #include <conio.h>
@@ -16,120 +29,450 @@
 #define getch _getch
 
 #else
-#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
 #include <termios.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #endif
 
-int hexes_get_char() {
+// The process's own terminal is defined at the bottom of this file.
+static const hexes_backend_t terminalBackend;
+static const hexes_backend_t* backend = &terminalBackend;
+
+// MARK: - Output buffering
+
+static string_buf_t frame = {0, 0, NULL};
+static int frameDepth = 0;
+
+static int frameInterval = 0;
+static int64_t lastFrame = 0;
+
+static int64_t now_ms() {
 #ifdef _WIN32
-    return _getch();
+    return 0;
 #else
-    struct termios oldt, newt;
-    int ch;
-    tcgetattr(STDIN_FILENO, &oldt);
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO);
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-    ch = getchar();
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-    return ch;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
 #endif
 }
 
-HexesKey hexes_get_key() {
-    int buf[3];
-
-    char c = hexes_get_char();
-    switch(c) {
-    case KEY_ESC:
-        if((buf[0] = hexes_get_char()) < 0) return KEY_ESC;
-        if((buf[1] = hexes_get_char()) < 0) return KEY_ESC;
-
-        if(buf[0] == '[') {
-            // If we have a digit, then we have an extended escape sequence
-            if(isdigit(buf[1])) {
-                if((buf[2] = hexes_get_char()) < 0) return KEY_ESC;
-                if(buf[2] == '~') {
-                    switch(buf[1]) {
-                        case '3': return KEY_DELETE;
-                        case '5': return KEY_PAGE_UP;
-                        case '6': return KEY_PAGE_DOWN;
-                    }
-                }
-            } else {
-                switch(buf[1]) {
-                    case 'A': return KEY_ARROW_UP;
-                    case 'B': return KEY_ARROW_DOWN;
-                    case 'C': return KEY_ARROW_RIGHT;
-                    case 'D': return KEY_ARROW_LEFT;
-                }
-            }
+static void write_all(const char* data, int length) {
+#ifdef _WIN32
+    fwrite(data, 1, length, stdout);
+    fflush(stdout);
+#else
+    while(length > 0) {
+        ssize_t written = write(STDOUT_FILENO, data, length);
+        if(written < 0) {
+            if(errno == EINTR) continue;
+            return;
         }
-        break;
-    default:
-        return c;
-    }
-    return -1;
-}
-
-HexesKey hexes_get_key_raw() {
-    int buf[3];
-
-    char c = getchar();
-    switch(c) {
-    case KEY_ESC:
-        if((buf[0] = getchar()) < 0) return KEY_ESC;
-        if((buf[1] = getchar()) < 0) return KEY_ESC;
-
-        if(buf[0] == '[') {
-            // If we have a digit, then we have an extended escape sequence
-            if(isdigit(buf[1])) {
-                if((buf[2] = getchar()) < 0) return KEY_ESC;
-                if(buf[2] == '~') {
-                    switch(buf[1]) {
-                        case '3': return KEY_DELETE;
-                        case '5': return KEY_PAGE_UP;
-                        case '6': return KEY_PAGE_DOWN;
-                    }
-                }
-            } else {
-                switch(buf[1]) {
-                    case 'A': return KEY_ARROW_UP;
-                    case 'B': return KEY_ARROW_DOWN;
-                    case 'C': return KEY_ARROW_RIGHT;
-                    case 'D': return KEY_ARROW_LEFT;
-                }
+        STATS_ADD(writes, 1);
+        STATS_ADD(bytes, written);
+        data += written;
+        length -= written;
+    }
+#endif
+}
+
+// MARK: - Synchronized output
+// Terminals that know DEC mode 2026 hold off repainting between the begin and end markers, so each
+// frame shows up in one go instead of half-drawn. We check the terminal's capabilities the first
+// time we go raw, and only wrap frames when it knows the mode.
+
+#define SYNC_BEGIN "\033[?2026h"
+#define SYNC_END "\033[?2026l"
+
+static int syncMode = -1; // -1 until we know, then 0 or 1.
+
+// Writes to a backend other than the terminal, whose own writes are counted in write_all().
+static void backend_write(const char* data, int length) {
+    STATS_ADD(writes, 1);
+    STATS_ADD(bytes, length);
+    backend->write(backend->context, data, length);
+}
+
+static void write_frame(const char* data, int length) {
+    if(syncMode == 1) STATS_ADD(escapes[TERM_ESCAPE_MODE], 2);
+    if(backend != &terminalBackend) {
+        if(syncMode == 1) backend_write(SYNC_BEGIN, sizeof(SYNC_BEGIN) - 1);
+        backend_write(data, length);
+        if(syncMode == 1) backend_write(SYNC_END, sizeof(SYNC_END) - 1);
+        return;
+    }
+#ifndef _WIN32
+    if(syncMode == 1) {
+        struct iovec parts[] = {
+            {SYNC_BEGIN, sizeof(SYNC_BEGIN) - 1},
+            {(void*)data, length},
+            {SYNC_END, sizeof(SYNC_END) - 1},
+        };
+        ssize_t written;
+        do {
+            written = writev(STDOUT_FILENO, parts, 3);
+        } while(written < 0 && errno == EINTR);
+        if(written < 0) return;
+        STATS_ADD(writes, 1);
+        STATS_ADD(bytes, written);
+
+        // Short writes are rare on a terminal, but we still owe it whatever didn't go through.
+        for(int i = 0; i < 3; ++i) {
+            if((size_t)written >= parts[i].iov_len) {
+                written -= parts[i].iov_len;
+                continue;
             }
+            write_all((const char*)parts[i].iov_base + written, parts[i].iov_len - written);
+            written = 0;
         }
-        break;
-    default:
-        return c;
+        return;
     }
-    return -1;
+#endif
+    write_all(data, length);
 }
 
-int hexes_get_size(int* x, int* y) {
+bool hexes_sync_supported() {
+    return syncMode == 1;
+}
+
+void hexes_set_sync(bool enabled) {
+    syncMode = enabled ? 1 : 0;
+}
+
+// MARK: - Frames
+
+void hexes_frame_begin() {
+    if(!frame.data) string_buf_init(&frame);
+    frameDepth += 1;
+}
+
+void hexes_frame_end() {
+    assert(frameDepth > 0 && "hexes_frame_end() called without a matching hexes_frame_begin()");
+    frameDepth -= 1;
+    if(frameDepth || !frame.count) return;
+    // Anything the caller printed through stdio must reach the terminal before the frame does.
+    if(backend == &terminalBackend) fflush(stdout);
+    write_frame(frame.data, frame.count);
+    record_frame(&frame);
+    frame.count = 0;
+    if(frameInterval) lastFrame = now_ms();
+}
+
+bool hexes_frame_active() {
+    return frameDepth > 0;
+}
+
+int hexes_frame_suspend() {
+    int depth = frameDepth;
+    if(!depth) return 0;
+    frameDepth = 1;
+    hexes_frame_end();
+    return depth;
+}
+
+void hexes_frame_resume(int depth) {
+    assert(!frameDepth && "cannot resume a frame in the middle of another one");
+    if(!depth) return;
+    hexes_frame_begin();
+    frameDepth = depth;
+}
+
+void hexes_set_frame_interval(int interval) {
+    assert(interval >= 0 && "frame interval cannot be negative");
+    frameInterval = interval;
+}
+
+int hexes_frame_delay() {
+    if(!frameInterval) return 0;
+    int64_t delay = lastFrame + frameInterval - now_ms();
+    return delay > 0 ? (int)delay : 0;
+}
+
+// Outside of frames, the terminal backend goes through stdio so that we stay in order with whatever
+// else the program prints.
+void hexes_write(const char* data, int length) {
+    if(frameDepth) {
+        string_buf_append_n(&frame, data, length);
+        return;
+    }
+    if(backend == &terminalBackend) {
+        fwrite(data, 1, length, stdout);
+        STATS_ADD(bytes, length);
+    } else {
+        backend_write(data, length);
+    }
+    record_output(data, length);
+}
+
+void hexes_puts(const char* str) {
+    hexes_write(str, strlen(str));
+}
+
+void hexes_putc(char c) {
+    if(frameDepth) {
+        string_buf_append(&frame, c);
+        return;
+    }
+    if(backend == &terminalBackend) {
+        putchar(c);
+        STATS_ADD(bytes, 1);
+    } else {
+        backend_write(&c, 1);
+    }
+    record_output(&c, 1);
+}
+
+int hexes_printf(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    if(!frameDepth && backend == &terminalBackend && !hexes_recording()) {
+        int length = vprintf(fmt, args);
+        va_end(args);
+        if(length > 0) STATS_ADD(bytes, length);
+        return length;
+    }
+    // Other backends get the text in one go, through a frame of its own. So does the terminal when
+    // we're recording, so that the recorder gets to see it.
+    hexes_frame_begin();
+
+    va_list copy;
+    va_copy(copy, args);
+    int available = frame.capacity - frame.count;
+    int length = vsnprintf(frame.data + frame.count, available, fmt, args);
+    if(length >= available) {
+        string_buf_ensure(&frame, frame.count + length + 1);
+        vsnprintf(frame.data + frame.count, length + 1, fmt, copy);
+    }
+    va_end(copy);
+    va_end(args);
+    if(length > 0) frame.count += length;
+    hexes_frame_end();
+    return length;
+}
+
+// MARK: - Terminal modes
+// We save the terminal's settings the first time we change them, and only ever switch between
+// three states: the saved settings, non-canonical (input session) and raw. The saved settings are
+// put back at exit, or when we're killed by a signal, whatever mode we were in. Other backends are
+// just told which of the three states they should be in.
+
+static bool inRawMode = false;
+static bool inSession = false;
+
+#ifndef _WIN32
+static struct termios savedTerm;
+static bool haveSavedTerm = false;
+static volatile sig_atomic_t termModified = 0;
+// Modes that change what the terminal sends us. They are turned off along with the saved settings,
+// so a program that dies with them on doesn't leave the shell getting paste markers or mouse
+// reports.
+static volatile sig_atomic_t pasteModeOn = 0;
+static volatile sig_atomic_t mouseModeOn = 0;
+
+#define MOUSE_OFF "\033[?1000l\033[?1002l\033[?1003l\033[?1006l"
+
+static const int restoreSignals[] = {SIGINT, SIGTERM, SIGHUP, SIGQUIT};
+#define RESTORE_SIGNAL_COUNT (int)(sizeof(restoreSignals) / sizeof(restoreSignals[0]))
+static struct sigaction previousActions[RESTORE_SIGNAL_COUNT];
+
+static void restore_terminal() {
+    // We may be in a signal handler, where stdio isn't safe: write(2) is.
+    if(pasteModeOn) write_all("\033[?2004l", 8);
+    pasteModeOn = 0;
+    if(mouseModeOn) write_all(MOUSE_OFF, sizeof(MOUSE_OFF) - 1);
+    mouseModeOn = 0;
+    if(!termModified) return;
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &savedTerm);
+    termModified = 0;
+}
+
+static void restore_on_signal(int signal) {
+    restore_terminal();
+    for(int i = 0; i < RESTORE_SIGNAL_COUNT; ++i) {
+        if(restoreSignals[i] != signal) continue;
+        sigaction(signal, &previousActions[i], NULL);
+    }
+    raise(signal);
+}
+
+static bool save_terminal() {
+    if(haveSavedTerm) return true;
+    if(!isatty(STDIN_FILENO)) return false;
+    if(tcgetattr(STDIN_FILENO, &savedTerm) == -1) return false;
+    haveSavedTerm = true;
+
+    atexit(restore_terminal);
+    for(int i = 0; i < RESTORE_SIGNAL_COUNT; ++i) {
+        struct sigaction action;
+        action.sa_handler = restore_on_signal;
+        action.sa_flags = 0;
+        sigemptyset(&action.sa_mask);
+        // We only step in where the program would have died anyway.
+        if(sigaction(restoreSignals[i], NULL, &previousActions[i]) < 0) continue;
+        if(previousActions[i].sa_handler != SIG_DFL) continue;
+        sigaction(restoreSignals[i], &action, NULL);
+    }
+    return true;
+}
+
+static void apply_mode(hexes_mode_t target, int when) {
+    if(!save_terminal()) return;
+
+    if(target == HEXES_MODE_NORMAL) {
+        tcsetattr(STDIN_FILENO, when, &savedTerm);
+        termModified = 0;
+        return;
+    }
+
+    struct termios mode = savedTerm;
+    if(target == HEXES_MODE_RAW) {
+        mode.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+        mode.c_oflag &= ~(OPOST);
+        mode.c_cflag |= (CS8);
+        mode.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+        /* control chars - set return condition: min number of bytes and timer. */
+        // mode.c_cc[VMIN] = 0; /* Return each byte, or zero for timeout. */
+        // mode.c_cc[VTIME] = 1; /* 100 ms timeout (unit is tens of second). */
+    } else {
+        mode.c_lflag &= ~(ICANON | ECHO);
+    }
+    termModified = 1;
+    tcsetattr(STDIN_FILENO, when, &mode);
+}
+#endif
+
+static void set_mode() {
+    hexes_mode_t mode = HEXES_MODE_NORMAL;
+    if(inRawMode)
+        mode = HEXES_MODE_RAW;
+    else if(inSession)
+        mode = HEXES_MODE_SESSION;
+    backend->mode(backend->context, mode);
+}
+
+void hexes_session_begin() {
+    if(inSession) return;
+    inSession = true;
+    if(!inRawMode) set_mode();
+}
+
+void hexes_session_end() {
+    if(!inSession) return;
+    inSession = false;
+    if(!inRawMode) set_mode();
+}
+
+bool hexes_session_active() {
+    return inSession;
+}
+
+void hexes_raw_start() {
+    if(inRawMode) return;
+    inRawMode = true;
+    set_mode();
+    if(syncMode < 0) syncMode = hexes_caps()->sync;
+}
+
+void hexes_raw_stop() {
+    if(!inRawMode) return;
+    inRawMode = false;
+    set_mode();
+}
+
+// MARK: - Input
+
+int hexes_get_char() {
+#ifdef _WIN32
+    return _getch();
+#else
+    if(!inRawMode) hexes_session_begin();
+    return input_read_byte();
+#endif
+}
+
+HexesKey hexes_get_key() {
+#ifndef _WIN32
+    if(!inRawMode) hexes_session_begin();
+#endif
+    return hexes_get_key_raw();
+}
+
+// MARK: - Terminal size
+// The size is only asked to the terminal again after SIGWINCH tells us it changed. The handler
+// also writes to a pipe, so that the event loop can wake up and report the resize.
+
+static int cachedWidth = 0, cachedHeight = 0;
+static volatile sig_atomic_t sizeStale = 1;
+
+#ifndef _WIN32
+static int resizePipe[2] = {-1, -1};
+static struct sigaction previousWinch;
+
+static void on_winch(int signal, siginfo_t* info, void* context) {
+    sizeStale = 1;
+    int saved = errno;
+    char c = 0;
+    if(write(resizePipe[1], &c, 1) < 0) {
+        // The pipe is full, which means a resize is already pending.
+    }
+    errno = saved;
+
+    // Whoever had the signal before us still gets it, the way they asked for it.
+    if(previousWinch.sa_flags & SA_SIGINFO)
+        previousWinch.sa_sigaction(signal, info, context);
+    else if(previousWinch.sa_handler != SIG_DFL && previousWinch.sa_handler != SIG_IGN)
+        previousWinch.sa_handler(signal);
+}
+
+int resize_watch() {
+    if(resizePipe[0] >= 0) return resizePipe[0];
+    if(pipe(resizePipe) < 0) return -1;
+    for(int i = 0; i < 2; ++i) {
+        fcntl(resizePipe[i], F_SETFL, fcntl(resizePipe[i], F_GETFL) | O_NONBLOCK);
+        fcntl(resizePipe[i], F_SETFD, FD_CLOEXEC);
+    }
+
+    struct sigaction action;
+    action.sa_sigaction = on_winch;
+    action.sa_flags = SA_RESTART | SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGWINCH, &action, &previousWinch);
+    return resizePipe[0];
+}
+
+void resize_drain() {
+    char buffer[64];
+    while(read(resizePipe[0], buffer, sizeof(buffer)) > 0)
+        ;
+}
+#endif
+
+static int query_size(int* x, int* y) {
     #ifdef _WIN32
     	CONSOLE_SCREEN_BUFFER_INFO info;
     	if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info))
     		return -1;
-        if(x) *x = info.srWindow.Right - info.srWindow.Left + 1;
-        if(y) *y = info.srWindow.Bottom - info.srWindow.Top + 1
+        *x = info.srWindow.Right - info.srWindow.Left + 1;
+        *y = info.srWindow.Bottom - info.srWindow.Top + 1;
         return 0;
     #else
     #ifdef TIOCGSIZE
     	struct ttysize ts;
-    	ioctl(STDIN_FILENO, TIOCGSIZE, &ts);
-        if(x) *x = ts.ts_cols;
-        if(y) *y = ts.ts_lines;
+    	if(ioctl(STDIN_FILENO, TIOCGSIZE, &ts) < 0) return -1;
+        *x = ts.ts_cols;
+        *y = ts.ts_lines;
         return 0;
     #elif defined(TIOCGWINSZ)
     	struct winsize ts;
-    	ioctl(STDIN_FILENO, TIOCGWINSZ, &ts);
-        if(x) *x = ts.ws_col;
-        if(y) *y = ts.ws_row;
+    	if(ioctl(STDIN_FILENO, TIOCGWINSZ, &ts) < 0) return -1;
+        *x = ts.ws_col;
+        *y = ts.ws_row;
         return 0;
     #else // TIOCGSIZE
     	return -1;
@@ -137,104 +480,233 @@ int hexes_get_size(int* x, int* y) {
     #endif // _WIN32
 }
 
+int hexes_get_size(int* x, int* y) {
+    if(backend != &terminalBackend) {
+        int width = 0, height = 0;
+        if(backend->size(backend->context, &width, &height) < 0) return -1;
+        if(x) *x = width;
+        if(y) *y = height;
+        return 0;
+    }
+#ifdef _WIN32
+    // There is no SIGWINCH to tell us when to look again.
+    sizeStale = 1;
+#else
+    resize_watch();
+#endif
+    if(sizeStale) {
+        // Clear the flag first, so a resize that lands during the query isn't lost.
+        sizeStale = 0;
+        if(query_size(&cachedWidth, &cachedHeight) < 0) {
+            sizeStale = 1;
+            return -1;
+        }
+    }
+    if(x) *x = cachedWidth;
+    if(y) *y = cachedHeight;
+    return 0;
+}
+
+void hexes_set_bracketed_paste(bool enabled) {
+    STATS_ESCAPE(TERM_ESCAPE_MODE);
+#ifndef _WIN32
+    if(backend == &terminalBackend) pasteModeOn = enabled;
+#endif
+    if(enabled)
+        hexes_puts("\033[?2004h");
+    else
+        hexes_puts("\033[?2004l");
+}
+
+void hexes_set_mouse(hexes_mouse_mode_t mode) {
+    static const char* modes[] = {
+        [HEXES_MOUSE_CLICKS] = "\033[?1000",
+        [HEXES_MOUSE_DRAG] = "\033[?1002",
+        [HEXES_MOUSE_MOTION] = "\033[?1003",
+    };
+    static hexes_mouse_mode_t current = HEXES_MOUSE_OFF;
+    if(mode == current) return;
+
+    // Reports are sent in SGR form from the moment tracking starts until it stops. Terminals keep
+    // each tracking mode separately, so the one we had is turned off.
+    bool encoding = (current == HEXES_MOUSE_OFF) != (mode == HEXES_MOUSE_OFF);
+    hexes_frame_begin();
+    if(encoding && mode != HEXES_MOUSE_OFF) {
+        STATS_ESCAPE(TERM_ESCAPE_MODE);
+        hexes_puts("\033[?1006h");
+    }
+    if(current != HEXES_MOUSE_OFF) {
+        STATS_ESCAPE(TERM_ESCAPE_MODE);
+        hexes_puts(modes[current]);
+        hexes_putc('l');
+    }
+    if(mode != HEXES_MOUSE_OFF) {
+        STATS_ESCAPE(TERM_ESCAPE_MODE);
+        hexes_puts(modes[mode]);
+        hexes_putc('h');
+    }
+    if(encoding && mode == HEXES_MOUSE_OFF) {
+        STATS_ESCAPE(TERM_ESCAPE_MODE);
+        hexes_puts("\033[?1006l");
+    }
+    hexes_frame_end();
+    current = mode;
+#ifndef _WIN32
+    if(backend == &terminalBackend) mouseModeOn = mode != HEXES_MOUSE_OFF;
+#endif
+}
+
 void hexes_show_cursor(bool show) {
-        if(show)
-            printf("\033[?25h");
-        else
-            printf("\033[?25l");
+    STATS_ESCAPE(TERM_ESCAPE_MODE);
+    if(show)
+        hexes_puts("\033[?25h");
+    else
+        hexes_puts("\033[?25l");
 }
 
 void hexes_set_alternate(bool alt) {
+    STATS_ESCAPE(TERM_ESCAPE_MODE);
     if(alt)
-        printf("\033[?1049h");
+        hexes_puts("\033[?1049h");
     else
-        printf("\033[?1049l");
+        hexes_puts("\033[?1049l");
+}
+
+static void cursor_move(int n, char direction) {
+    if(n <= 0) return;
+    char buffer[CSI_MAX_LENGTH];
+    hexes_write(buffer, csi_cursor_move(buffer, n, direction));
 }
 
 void hexes_cursor_up(int n) {
     #ifdef _WIN32
     #else
-    if(n)printf("\033[%dA", n);
+    cursor_move(n, 'A');
     #endif
 }
 
 void hexes_cursor_down(int n) {
     #ifdef _WIN32
     #else
-    if(n)printf("\033[%dB", n);
+    cursor_move(n, 'B');
     #endif
 }
 
 void hexes_cursor_left(int n) {
     #ifdef _WIN32
     #else
-    if(n)printf("\033[%dD", n);
+    cursor_move(n, 'D');
     #endif
 }
 
 void hexes_cursor_right(int n) {
     #ifdef _WIN32
     #else
-    if(n)printf("\033[%dC", n);
+    cursor_move(n, 'C');
     #endif
 }
 
 void hexes_cursor_go(int x, int y) {
     #ifdef _WIN32
     #else
-    // printf("\033[%d;1H\033[2K", 1 + i);
-    printf("\033[%d;%dH", y+1, x+1);
+    char buffer[CSI_MAX_LENGTH];
+    hexes_write(buffer, csi_cursor_go(buffer, x, y));
     #endif
 }
 
-static bool inRawMode = false;
-
-#ifndef _WIN32
-static struct termios savedTerm;
+void hexes_clear_line() {
+#ifdef _WIN32
+#else
+    STATS_ESCAPE(TERM_ESCAPE_ERASE);
+    hexes_puts("\033[2K");
 #endif
+}
 
-void hexes_raw_start() {
-    if(inRawMode) return;
+void hexes_clear_screen() {
 #ifdef _WIN32
 #else
-    struct termios raw;
-
-    if (!isatty(STDIN_FILENO)) return;
-    // atexit(editorAtExit);
-    if (tcgetattr(STDIN_FILENO,&savedTerm) == -1) return;
-
-    raw = savedTerm;
-    raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
-    raw.c_oflag &= ~(OPOST);
-    raw.c_cflag |= (CS8);
-    raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
-    /* control chars - set return condition: min number of bytes and timer. */
-    // raw.c_cc[VMIN] = 0; /* Return each byte, or zero for timeout. */
-    // raw.c_cc[VTIME] = 1; /* 100 ms timeout (unit is tens of second). */
-    if (tcsetattr(STDIN_FILENO,TCSAFLUSH,&raw) < 0) return;
-    inRawMode = true;
+    STATS_ESCAPE(TERM_ESCAPE_ERASE);
+    hexes_puts("\033[2J");
 #endif
 }
 
-void hexes_raw_stop() {
-    if(!inRawMode) return;
+// MARK: - Backends
+
+#ifndef _WIN32
+static hexes_mode_t terminalMode = HEXES_MODE_NORMAL;
+#endif
+
+static int terminal_read(void* context, char* data, int size, int timeout) {
+    (void)context;
 #ifdef _WIN32
+    (void)size;
+    (void)timeout;
+    data[0] = _getch();
+    return 1;
 #else
-    tcsetattr(STDIN_FILENO,TCSAFLUSH,&savedTerm);
-    inRawMode = false;
+    if(timeout >= 0) {
+        struct pollfd fd = {STDIN_FILENO, POLLIN, 0};
+        int ready;
+        while((ready = poll(&fd, 1, timeout)) < 0 && errno == EINTR)
+            ;
+        if(ready <= 0) return 0;
+    }
+
+    ssize_t length;
+    while((length = read(STDIN_FILENO, data, size)) < 0 && errno == EINTR)
+        ;
+    return length > 0 ? (int)length : -1;
 #endif
 }
 
-void hexes_clear_line() {
+static void terminal_write(void* context, const char* data, int length) {
+    (void)context;
+    write_all(data, length);
+}
+
+static int terminal_size(void* context, int* width, int* height) {
+    (void)context;
+    return query_size(width, height);
+}
+
+static void terminal_mode(void* context, hexes_mode_t mode) {
+    (void)context;
 #ifdef _WIN32
+    (void)mode;
 #else
-    printf("\033[2K");
+    // Going in or out of raw mode drops input that was typed for the other mode.
+    bool raw = mode == HEXES_MODE_RAW, wasRaw = terminalMode == HEXES_MODE_RAW;
+    terminalMode = mode;
+    apply_mode(mode, raw != wasRaw ? TCSAFLUSH : TCSANOW);
 #endif
 }
 
-void hexes_clear_screen() {
+static const hexes_backend_t terminalBackend = {
+    .context = NULL,
 #ifdef _WIN32
+    .inputFd = -1,
 #else
-    printf("\033[2J");
+    .inputFd = STDIN_FILENO,
 #endif
+    .read = terminal_read,
+    .write = terminal_write,
+    .size = terminal_size,
+    .mode = terminal_mode,
+};
+
+void hexes_set_backend(const hexes_backend_t* newBackend) {
+    assert(!frameDepth && "cannot change backends in the middle of a frame");
+    backend = newBackend ? newBackend : &terminalBackend;
+    term_style_invalidate(stdout);
+    if(inRawMode || inSession) set_mode();
+    // Whether frames can be synchronized is up to the new terminal.
+    syncMode = inRawMode ? hexes_caps()->sync : -1;
+}
+
+const hexes_backend_t* hexes_get_backend() {
+    return backend;
+}
+
+const hexes_backend_t* hexes_terminal_backend() {
+    return &terminalBackend;
 }
@@ -0,0 +1,621 @@
+//===--------------------------------------------------------------------------------------------===
+// input.c - buffered terminal input decoder
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#include <term/hexes.h>
+#include <term/backend.h>
+#include "input.h"
+#include "instrument.h"
+#include "recorder.h"
+#include "string_buf.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+#define INPUT_BUFFER_SIZE   4096
+#define INPUT_QUEUE_SIZE    256
+#define INPUT_MAX_PARAMS    8
+#define INPUT_MAX_SEQUENCE  64
+#define INPUT_MAX_STRING    512
+
+// Queued events refer to pasted text by offset, because the paste buffer can move while it grows.
+typedef struct {
+    hexes_event_t event;
+    int textOffset;
+} queued_event_t;
+
+typedef struct {
+    uint8_t bytes[INPUT_BUFFER_SIZE];
+    int head;
+    int count;
+
+    queued_event_t events[INPUT_QUEUE_SIZE];
+    int eventHead;
+    int eventCount;
+
+    bool pasting;
+    int pasteStart;
+    string_buf_t paste;
+    const char* lastPaste;
+    int lastPasteLength;
+
+    bool closed;
+    int64_t readTime;
+
+    int mouseX, mouseY;
+} input_t;
+
+static input_t in = {
+    .head = 0,
+    .count = 0,
+    .eventHead = 0,
+    .eventCount = 0,
+    .pasting = false,
+    .paste = {0, 0, NULL},
+    .lastPaste = NULL,
+    .lastPasteLength = 0,
+    .closed = false,
+    .readTime = 0,
+    .mouseX = -1,
+    .mouseY = -1
+};
+
+// MARK: - Byte buffer
+
+static inline int peek(int i) {
+    return in.bytes[(in.head + i) % INPUT_BUFFER_SIZE];
+}
+
+static inline void consume(int count) {
+    assert(count <= in.count && "consuming more input than was read");
+    in.head = (in.head + count) % INPUT_BUFFER_SIZE;
+    in.count -= count;
+}
+
+// Reads whatever the backend has into the ring buffer with a single read. If [timeout] is not
+// negative, we give up after that many milliseconds without input.
+static bool fill(int timeout) {
+    if(in.closed || in.count == INPUT_BUFFER_SIZE) return false;
+
+    int tail = (in.head + in.count) % INPUT_BUFFER_SIZE;
+    int space = INPUT_BUFFER_SIZE - in.count;
+    if(tail + space > INPUT_BUFFER_SIZE) space = INPUT_BUFFER_SIZE - tail;
+
+    const hexes_backend_t* backend = hexes_get_backend();
+    int length = backend->read(backend->context, (char*)in.bytes + tail, space, timeout);
+    if(length < 0) in.closed = true;
+    if(length <= 0) return false;
+    record_input((const char*)in.bytes + tail, length);
+    in.readTime = hexes_clock();
+    in.count += length;
+    return true;
+}
+
+// MARK: - Sequence tables
+
+typedef struct {
+    uint8_t final;
+    HexesKey key;
+} final_key_t;
+
+// Keys identified by the final byte of a CSI (ESC [) or SS3 (ESC O) sequence.
+static const final_key_t finalKeys[] = {
+    {'A', KEY_ARROW_UP},
+    {'B', KEY_ARROW_DOWN},
+    {'C', KEY_ARROW_RIGHT},
+    {'D', KEY_ARROW_LEFT},
+    {'H', KEY_HOME},
+    {'F', KEY_END},
+    {'P', KEY_F1},
+    {'Q', KEY_F2},
+    {'R', KEY_F3},
+    {'S', KEY_F4},
+    {'Z', KEY_TAB},
+    {0, 0},
+};
+
+// Keys identified by the first parameter of a "ESC [ n ~" sequence.
+static const HexesKey tildeKeys[] = {
+    [1] = KEY_HOME,
+    [2] = KEY_INSERT,
+    [3] = KEY_DELETE,
+    [4] = KEY_END,
+    [5] = KEY_PAGE_UP,
+    [6] = KEY_PAGE_DOWN,
+    [7] = KEY_HOME,
+    [8] = KEY_END,
+    [11] = KEY_F1,
+    [12] = KEY_F2,
+    [13] = KEY_F3,
+    [14] = KEY_F4,
+    [15] = KEY_F5,
+    [17] = KEY_F6,
+    [18] = KEY_F7,
+    [19] = KEY_F8,
+    [20] = KEY_F9,
+    [21] = KEY_F10,
+    [23] = KEY_F11,
+    [24] = KEY_F12,
+};
+
+static HexesKey find_final(int final) {
+    for(int i = 0; finalKeys[i].final; ++i) {
+        if(finalKeys[i].final == final) return finalKeys[i].key;
+    }
+    return 0;
+}
+
+// MARK: - Decoding
+
+static void decode(bool timedOut);
+
+static void push(hexes_event_t event, int textOffset) {
+    assert(in.eventCount < INPUT_QUEUE_SIZE && "input event queue overflow");
+    queued_event_t* queued = &in.events[(in.eventHead + in.eventCount) % INPUT_QUEUE_SIZE];
+    queued->event = event;
+    queued->event.time = in.readTime;
+    queued->textOffset = textOffset;
+    in.eventCount += 1;
+}
+
+static void push_key(HexesKey key, int mods) {
+    STATS_ADD(keys, 1);
+    push((hexes_event_t){.kind = HEXES_EVENT_KEY, .key = key, .mods = mods}, -1);
+}
+
+// MARK: - Bracketed paste
+
+static const char pasteEnd[] = "\033[201~";
+#define PASTE_END_LENGTH ((int)sizeof(pasteEnd) - 1)
+
+static void start_paste() {
+    if(!in.paste.data) string_buf_init(&in.paste);
+    in.pasting = true;
+    in.pasteStart = in.paste.count;
+}
+
+// Copies everything up to the end-of-paste marker into the paste buffer, a contiguous run of the
+// ring buffer at a time. Returns the number of bytes used, or 0 if we need more input to tell
+// whether an ESC starts the marker. Once [timedOut], or once there is no more input to come, an
+// ESC that could still start the marker is taken as part of the text.
+static int parse_paste(bool timedOut) {
+    const uint8_t* run = in.bytes + in.head;
+    int length = in.count;
+    if(in.head + length > INPUT_BUFFER_SIZE) length = INPUT_BUFFER_SIZE - in.head;
+
+    const uint8_t* esc = memchr(run, KEY_ESC, length);
+    if(esc != run) {
+        int used = esc ? (int)(esc - run) : length;
+        string_buf_append_n(&in.paste, (const char*)run, used);
+        return used;
+    }
+
+    int matched = 0;
+    while(matched < PASTE_END_LENGTH && matched < in.count && peek(matched) == pasteEnd[matched])
+        matched += 1;
+
+    if(matched == PASTE_END_LENGTH) {
+        hexes_event_t event = {
+            .kind = HEXES_EVENT_PASTE,
+            .key = KEY_PASTE,
+            .mods = 0,
+            .length = in.paste.count - in.pasteStart
+        };
+        push(event, in.pasteStart);
+        in.pasting = false;
+        return PASTE_END_LENGTH;
+    }
+    if(matched == in.count && !timedOut && !in.closed) return 0;
+
+    string_buf_append(&in.paste, KEY_ESC);
+    return 1;
+}
+
+// xterm encodes modifiers as 1 + (shift | alt << 1 | ctrl << 2), which matches HexesMod.
+static inline int decode_mods(int param) {
+    return param > 1 ? (param - 1) & (HEXES_MOD_SHIFT | HEXES_MOD_ALT | HEXES_MOD_CTRL) : 0;
+}
+
+typedef struct {
+    int params[INPUT_MAX_PARAMS];
+    int count;
+    int prefix;         // '?', '<', '=' or '>' for private sequences
+    int intermediate;
+    int final;
+} csi_t;
+
+// MARK: - Terminal reports
+// Replies to the queries we send the terminal (device attributes, mode reports...) are kept out of
+// the event queue, and wait in their own small queue for whoever asked.
+
+static input_report_t reports[INPUT_MAX_REPORTS];
+static int reportHead = 0;
+static int reportCount = 0;
+
+static input_report_t* push_report(const csi_t* csi) {
+    if(reportCount == INPUT_MAX_REPORTS) {
+        // Nobody is reading them: drop the oldest.
+        reportHead = (reportHead + 1) % INPUT_MAX_REPORTS;
+        reportCount -= 1;
+    }
+    input_report_t* report = &reports[(reportHead + reportCount) % INPUT_MAX_REPORTS];
+    report->kind = INPUT_REPORT_CSI;
+    report->prefix = csi->prefix;
+    report->intermediate = csi->intermediate;
+    report->final = csi->final;
+    report->count = csi->count;
+    for(int i = 0; i < csi->count; ++i) report->params[i] = csi->params[i];
+    report->length = 0;
+    report->text[0] = '\0';
+    reportCount += 1;
+    return report;
+}
+
+static int64_t now_ms() {
+#ifdef _WIN32
+    return 0;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+bool input_wait_report(input_report_t* report, int timeout) {
+    int64_t deadline = now_ms() + timeout;
+    for(;;) {
+        decode(false);
+        if(reportCount) {
+            *report = reports[reportHead];
+            reportHead = (reportHead + 1) % INPUT_MAX_REPORTS;
+            reportCount -= 1;
+            return true;
+        }
+
+        int64_t remaining = deadline - now_ms();
+        if(remaining <= 0 || in.closed) return false;
+        fill((int)remaining);
+    }
+}
+
+// MARK: - Mouse
+// With mode 1006, the terminal reports the mouse as "ESC [ < button ; x ; y M", or m for a
+// release. The low bits of [button] say which button; higher ones add modifiers (4, 8, 16), tell
+// moves (32) and wheel turns (64) apart, and coordinates count from 1. Buttons 8 to 11 (back,
+// forward and the like) set 128, and are ignored: their low bits would read as the first four.
+
+// Merges moves and wheel turns into the one before them if the program hasn't read it yet, so that
+// reports piling up while it's busy cost it one event.
+static void push_mouse(hexes_event_t event) {
+    if(in.eventCount && (event.action == HEXES_MOUSE_MOVE || event.action == HEXES_MOUSE_WHEEL)) {
+        int tail = (in.eventHead + in.eventCount - 1) % INPUT_QUEUE_SIZE;
+        hexes_event_t* last = &in.events[tail].event;
+        if(last->kind == HEXES_EVENT_MOUSE && last->action == event.action
+           && last->button == event.button && last->mods == event.mods) {
+            last->x = event.x;
+            last->y = event.y;
+            last->dx += event.dx;
+            last->dy += event.dy;
+            return;
+        }
+    }
+    push(event, -1);
+}
+
+static void decode_mouse(const csi_t* csi) {
+    if(csi->count < 3 || csi->params[0] < 0) return;
+    int code = csi->params[0];
+    if(code & 128) return;
+    hexes_event_t event = {
+        .kind = HEXES_EVENT_MOUSE,
+        .button = code & 3,
+        .x = csi->params[1] > 0 ? csi->params[1] - 1 : 0,
+        .y = csi->params[2] > 0 ? csi->params[2] - 1 : 0,
+        .mods = (code & 4 ? HEXES_MOD_SHIFT : 0)
+            | (code & 8 ? HEXES_MOD_ALT : 0)
+            | (code & 16 ? HEXES_MOD_CTRL : 0),
+    };
+
+    if(code & 64) {
+        static const int wheel[][2] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+        event.action = HEXES_MOUSE_WHEEL;
+        event.dx = wheel[code & 3][0];
+        event.dy = wheel[code & 3][1];
+        event.button = HEXES_BUTTON_NONE;
+    } else if(code & 32) {
+        event.action = HEXES_MOUSE_MOVE;
+        if(in.mouseX >= 0) {
+            event.dx = event.x - in.mouseX;
+            event.dy = event.y - in.mouseY;
+        }
+    } else {
+        event.action = csi->final == 'm' ? HEXES_MOUSE_RELEASE : HEXES_MOUSE_PRESS;
+    }
+    in.mouseX = event.x;
+    in.mouseY = event.y;
+    push_mouse(event);
+}
+
+// MARK: - Control sequences
+
+static void decode_csi(const csi_t* csi) {
+    if(csi->prefix == '<' && !csi->intermediate && (csi->final == 'M' || csi->final == 'm')) {
+        decode_mouse(csi);
+        return;
+    }
+    if(csi->prefix || csi->intermediate) {
+        push_report(csi);
+        return;
+    }
+    int mods = csi->count > 1 ? decode_mods(csi->params[1]) : 0;
+
+    if(csi->final == '~') {
+        int code = csi->count ? csi->params[0] : 0;
+        if(code == 200) {
+            start_paste();
+            return;
+        }
+        if(code <= 0 || code >= (int)(sizeof(tildeKeys) / sizeof(tildeKeys[0]))) return;
+        if(tildeKeys[code]) push_key(tildeKeys[code], mods);
+        return;
+    }
+
+    HexesKey key = find_final(csi->final);
+    if(!key) return;
+    if(csi->final == 'Z') mods |= HEXES_MOD_SHIFT;
+    push_key(key, mods);
+}
+
+// Reads the parameters, intermediate and final byte of a control sequence, starting at offset [i].
+// Returns the offset just past the final byte, or 0 if the sequence isn't complete yet. If we find a
+// byte that can't be part of a control sequence, csi->final is left at 0 and we return its offset.
+static int parse_header(csi_t* csi, int i) {
+    if(i < in.count && peek(i) >= '<' && peek(i) <= '?') csi->prefix = peek(i++);
+
+    bool inParam = false;
+    for(; i < in.count; ++i) {
+        int c = peek(i);
+        if(c >= '0' && c <= '9') {
+            if(!inParam && csi->count < INPUT_MAX_PARAMS) {
+                csi->params[csi->count++] = 0;
+                inParam = true;
+            }
+            int* param = &csi->params[csi->count - 1];
+            if(inParam && *param < 100000) *param = *param * 10 + (c - '0');
+        } else if(c == ';' || c == ':') {
+            if(!inParam && csi->count < INPUT_MAX_PARAMS) csi->params[csi->count++] = -1;
+            inParam = false;
+        } else if(c >= 0x20 && c <= 0x2f) {
+            csi->intermediate = c;
+        } else if(c >= 0x3c && c <= 0x3f) {
+            // Stray private markers: nothing we decode uses them.
+        } else if(c >= 0x40 && c <= 0x7e) {
+            csi->final = c;
+            return i + 1;
+        } else {
+            return i;
+        }
+        if(i >= INPUT_MAX_SEQUENCE) return i;
+    }
+    return 0;
+}
+
+// Parses "ESC [ params intermediates final" starting at the beginning of the buffer. Returns the
+// number of bytes used, or 0 if the sequence isn't complete yet.
+static int parse_csi() {
+    csi_t csi = {.count = 0, .prefix = 0, .intermediate = 0, .final = 0};
+    int used = parse_header(&csi, 2);
+    // An invalid sequence is dropped, up to the byte that broke it.
+    if(used && csi.final) decode_csi(&csi);
+    return used;
+}
+
+// Parses "ESC P params intermediates final data ST". Terminals only send these in reply to queries
+// (XTVERSION, for one), so they all go to the report queue. The data ends with ST (ESC \) or BEL:
+// an ESC followed by anything else means this was typed, and we return -1.
+static int parse_dcs() {
+    csi_t csi = {.count = 0, .prefix = 0, .intermediate = 0, .final = 0};
+    int start = parse_header(&csi, 2);
+    if(!start || !csi.final) return start;
+
+    for(int i = start; i < in.count; ++i) {
+        int c = peek(i);
+        int end = 0;
+        if(c == '\a') {
+            end = i + 1;
+        } else if(c == KEY_ESC) {
+            if(i + 1 == in.count) return 0;
+            if(peek(i + 1) != '\\') return -1;
+            end = i + 2;
+        } else if(i - start >= INPUT_MAX_STRING) {
+            return i;
+        }
+        if(!end) continue;
+
+        input_report_t* report = push_report(&csi);
+        report->kind = INPUT_REPORT_DCS;
+        report->length = i - start < INPUT_MAX_REPORT_TEXT - 1 ? i - start : INPUT_MAX_REPORT_TEXT - 1;
+        for(int j = 0; j < report->length; ++j) report->text[j] = peek(start + j);
+        report->text[report->length] = '\0';
+        return end;
+    }
+    return 0;
+}
+
+// Parses "ESC O final", used by some terminals for arrows, Home/End and F1-F4.
+static int parse_ss3() {
+    if(in.count < 3) return 0;
+    HexesKey key = find_final(peek(2));
+    if(key) push_key(key, 0);
+    return 3;
+}
+
+// Decodes one event from the start of the buffer. Returns the number of bytes used, or 0 if more
+// input is needed. When [timedOut] is set, no more input is coming soon, so an incomplete sequence
+// is read as a lone ESC.
+static int parse(bool timedOut) {
+    if(in.pasting) return parse_paste(timedOut);
+
+    int c = peek(0);
+    if(c != KEY_ESC) {
+        push_key(c, 0);
+        return 1;
+    }
+
+    int used = 0;
+    if(in.count >= 2) {
+        switch(peek(1)) {
+        case '[': used = parse_csi(); break;
+        case 'O': used = parse_ss3(); break;
+        case 'P':
+            used = parse_dcs();
+            // Not a reply, or one that never finished: this was Alt+Shift+P, and what follows it
+            // was typed.
+            if(used < 0 || (!used && timedOut)) {
+                push_key('P', HEXES_MOD_ALT);
+                return 2;
+            }
+            break;
+        case KEY_ESC: push_key(KEY_ESC, 0); return 1;
+        default:
+            push_key(peek(1), HEXES_MOD_ALT);
+            return 2;
+        }
+    }
+    if(used || !timedOut) return used;
+    push_key(KEY_ESC, 0);
+    return 1;
+}
+
+static void decode(bool timedOut) {
+    if(!in.count) return;
+    TRACE_BEGIN("decode");
+    while(in.count && in.eventCount < INPUT_QUEUE_SIZE - 1) {
+        int used = parse(timedOut);
+        if(!used) break;
+        consume(used);
+    }
+    TRACE_END("decode");
+}
+
+// Once every paste handed out so far has been read, its text doesn't need to stay around.
+static void release_pastes() {
+    if(!in.eventCount && !in.pasting) in.paste.count = 0;
+}
+
+// Makes sure there is at least one decoded event in the queue, reading more input if [wait] is set.
+static bool refill(bool wait) {
+    release_pastes();
+    while(!in.eventCount) {
+        decode(false);
+        if(in.eventCount) break;
+
+        if(in.count) {
+            // We're stuck in the middle of a sequence. Either the rest arrives shortly, or
+            // this was a lone ESC. Without [wait], the caller will ask again later.
+            if(!wait) return false;
+            if(!fill(INPUT_ESC_TIMEOUT)) decode(true);
+            continue;
+        }
+        if(!fill(wait ? -1 : 0)) return false;
+    }
+    return true;
+}
+
+static hexes_event_t pop() {
+    queued_event_t* queued = &in.events[in.eventHead];
+    in.eventHead = (in.eventHead + 1) % INPUT_QUEUE_SIZE;
+    in.eventCount -= 1;
+
+    hexes_event_t event = queued->event;
+    event.text = queued->textOffset >= 0 ? in.paste.data + queued->textOffset : NULL;
+    latency_input(event.time);
+    return event;
+}
+
+// MARK: - Public API
+
+bool hexes_next_event(hexes_event_t* event) {
+    assert(event && "cannot read an event into a null pointer");
+    if(!refill(true)) return false;
+    *event = pop();
+    return true;
+}
+
+int hexes_read_events(hexes_event_t* events, int max) {
+    assert(events && "cannot read events into a null pointer");
+    if(!refill(true)) return 0;
+    int count = 0;
+    while(count < max && in.eventCount) events[count++] = pop();
+    return count;
+}
+
+int hexes_pending_events() {
+    refill(false);
+    return in.eventCount;
+}
+
+HexesKey hexes_get_key_raw() {
+    hexes_event_t event;
+    if(!hexes_next_event(&event)) return -1;
+    if(event.kind == HEXES_EVENT_PASTE) {
+        in.lastPaste = event.text;
+        in.lastPasteLength = event.length;
+    }
+    // Mouse events carry no key, and a bare key code can't tell Alt+b from b: like any other
+    // input we can't return as a key, they are dropped.
+    if(event.kind != HEXES_EVENT_KEY && event.kind != HEXES_EVENT_PASTE) return -1;
+    if(event.mods & HEXES_MOD_ALT) return -1;
+    return event.key;
+}
+
+const char* hexes_get_paste(int* length) {
+    if(length) *length = in.lastPasteLength;
+    return in.lastPaste;
+}
+
+// MARK: - Event loop support
+
+bool input_ready() {
+    release_pastes();
+    if(!in.eventCount) decode(false);
+    return in.eventCount > 0;
+}
+
+bool input_waiting() {
+    return in.count > 0 && !in.pasting;
+}
+
+bool input_read(int timeout) {
+    return fill(timeout);
+}
+
+void input_timeout() {
+    decode(true);
+}
+
+bool input_pop(hexes_event_t* event) {
+    if(!in.eventCount) return false;
+    *event = pop();
+    return true;
+}
+
+bool input_closed() {
+    return in.closed;
+}
+
+int input_read_byte() {
+    if(!in.count && !fill(-1)) return -1;
+    int c = peek(0);
+    consume(1);
+    return c;
+}
@@ -0,0 +1,60 @@
+//===--------------------------------------------------------------------------------------------===
+// input.h - private interface to the hexes input decoder
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef term_input_h
+#define term_input_h
+#include <stdbool.h>
+#include <term/hexes.h>
+
+#define INPUT_ESC_TIMEOUT 25 // in milliseconds
+
+/// Returns the next undecoded byte of input, blocking until there is one. Returns -1 at the end of
+/// standard input.
+int input_read_byte();
+
+// The pieces of the decoder that the event loop drives itself, around its own poll() call.
+
+/// Decodes buffered input. Returns whether there is an event ready to be popped.
+bool input_ready();
+/// Returns whether buffered bytes are waiting for the rest of an escape sequence.
+bool input_waiting();
+/// Reads what the backend has, waiting up to [timeout] milliseconds. With a negative timeout, only
+/// call this when input is known to be readable.
+bool input_read(int timeout);
+/// Decodes the bytes left waiting as if nothing else was coming (for example, a lone ESC).
+void input_timeout();
+bool input_pop(hexes_event_t* event);
+bool input_closed();
+
+#define INPUT_MAX_REPORTS 16
+#define INPUT_MAX_REPORT_TEXT 64
+
+typedef enum {
+    INPUT_REPORT_CSI,
+    INPUT_REPORT_DCS,
+} input_report_kind_t;
+
+/// A reply from the terminal to a query, such as "ESC [ ? 2026 ; 2 $ y", or "ESC P > | text ST" for
+/// device control strings.
+typedef struct {
+    input_report_kind_t kind;
+    int prefix;         /// The private marker ('?', '>'...), or 0
+    int intermediate;   /// The intermediate byte ('$'...), or 0
+    int final;
+    int params[8];
+    int count;
+    char text[INPUT_MAX_REPORT_TEXT];  /// The data of a device control string, truncated
+    int length;
+} input_report_t;
+
+/// Waits up to [timeout] milliseconds for the terminal's next report. Input that arrives while we
+/// wait is decoded and queued as usual.
+bool input_wait_report(input_report_t* report, int timeout);
+
+#endif
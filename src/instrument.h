@@ -0,0 +1,74 @@
+//===--------------------------------------------------------------------------------------------===
+// instrument.h - hooks through which the library feeds its measurements
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef term_instrument_h
+#define term_instrument_h
+#include <term/latency.h>
+#include <term/stats.h>
+#include <term/trace.h>
+#include <stdint.h>
+
+// MARK: - Latency
+
+
+/// Notes that an input event read at [time] was handed to the program, and has yet to be shown.
+void latency_input(int64_t time);
+/// Notes that [source] just sent the terminal a frame showing everything it was given so far.
+void latency_presented(hexes_latency_source_t source);
+
+// MARK: - Counters
+// STATS_ADD(field, n) adds [n] to a field of term_stats_t. Without TERMUTILS_STATS, it compiles
+// to nothing, and [n] isn't evaluated.
+
+#ifdef TERMUTILS_STATS
+#include <stdatomic.h>
+
+typedef struct {
+    atomic_ullong bytes;
+    atomic_ullong writes;
+    atomic_ullong escapes[TERM_ESCAPE_KINDS];
+    atomic_ullong keys;
+    atomic_ullong reallocs;
+    atomic_ullong historyEntries;
+    atomic_ullong historyBytes;
+} stats_counters_t;
+
+extern stats_counters_t statsCounters;
+
+#define STATS_ADD(field, n) \
+    atomic_fetch_add_explicit(&statsCounters.field, (n), memory_order_relaxed)
+#define STATS_SUB(field, n) \
+    atomic_fetch_sub_explicit(&statsCounters.field, (n), memory_order_relaxed)
+#else
+#define STATS_ADD(field, n) ((void)0)
+#define STATS_SUB(field, n) ((void)0)
+#endif
+
+#define STATS_ESCAPE(kind) STATS_ADD(escapes[kind], 1)
+/// Counts the control sequence ending in [final] under its kind.
+#define STATS_CSI(final) STATS_ESCAPE(stats_escape_kind(final))
+
+term_escape_kind_t stats_escape_kind(char final);
+
+// MARK: - Tracing
+// TRACE_BEGIN() and TRACE_END() mark the start and end of a span named [name], which must be a
+// string literal. Without TERMUTILS_TRACE, they compile to nothing. Spans nest, but every begin
+// needs its end on the same thread, including on early returns.
+
+#ifdef TERMUTILS_TRACE
+void trace_event(const char* name, char phase);
+
+#define TRACE_BEGIN(name) trace_event((name), 'B')
+#define TRACE_END(name) trace_event((name), 'E')
+#else
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END(name) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,161 @@
+//===--------------------------------------------------------------------------------------------===
+// latency.c - input-to-screen latency histograms
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#include <term/latency.h>
+#include <term/hexes.h>
+#include "instrument.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+// Histograms are log-linear: every power of two is split into 16 buckets, so a bucket is never
+// more than 1/16th of its values wide. Values up to 16us get a bucket each, and anything past
+// 2^40us (about 12 days) ends up in the last one.
+#define LATENCY_SUB_BITS    4
+#define LATENCY_SUB_COUNT   (1 << LATENCY_SUB_BITS)
+#define LATENCY_MAX_BITS    40
+#define LATENCY_BUCKETS     ((LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT)
+
+typedef struct {
+    long count;
+    int64_t sum;
+    int64_t max;
+    long buckets[LATENCY_BUCKETS];
+} histogram_t;
+
+static histogram_t histograms[HEXES_LATENCY_SOURCES];
+static int64_t pending = -1; // When the oldest input that wasn't shown yet was read.
+static bool checkedEnv = false;
+static const char* dumpPath = NULL;
+
+int64_t hexes_clock() {
+#ifdef _WIN32
+    return 0;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+// MARK: - Histograms
+
+static int bucket_of(int64_t value) {
+    if(value < LATENCY_SUB_COUNT) return (int)value;
+    int top = LATENCY_SUB_BITS;
+    while(top < LATENCY_MAX_BITS && value >> (top + 1)) top += 1;
+    if(top >= LATENCY_MAX_BITS) return LATENCY_BUCKETS - 1;
+    int shift = top - LATENCY_SUB_BITS;
+    int sub = (int)(value >> shift) & (LATENCY_SUB_COUNT - 1);
+    return (shift + 1) * LATENCY_SUB_COUNT + sub;
+}
+
+// Returns the value in the middle of [bucket].
+static double bucket_value(int bucket) {
+    if(bucket < LATENCY_SUB_COUNT) return bucket;
+    int shift = bucket / LATENCY_SUB_COUNT - 1;
+    int sub = bucket % LATENCY_SUB_COUNT;
+    int64_t low = (int64_t)(LATENCY_SUB_COUNT + sub) << shift;
+    return low + ((int64_t)1 << shift) / 2.0;
+}
+
+static void add_sample(histogram_t* histogram, int64_t value) {
+    if(value < 0) value = 0;
+    histogram->count += 1;
+    histogram->sum += value;
+    if(value > histogram->max) histogram->max = value;
+    histogram->buckets[bucket_of(value)] += 1;
+}
+
+// Returns the value under which [fraction] of the samples fall, in microseconds.
+static double percentile(const histogram_t* histogram, double fraction) {
+    long rank = (long)(fraction * histogram->count + 0.5);
+    if(rank < 1) rank = 1;
+    long seen = 0;
+    for(int i = 0; i < LATENCY_BUCKETS; ++i) {
+        seen += histogram->buckets[i];
+        if(seen < rank) continue;
+        // The middle of the bucket can be past the largest value we actually saw.
+        double value = bucket_value(i);
+        return value < histogram->max ? value : histogram->max;
+    }
+    return histogram->max;
+}
+
+// MARK: - Dump at exit
+
+static void dump() {
+    if(!dumpPath) return;
+    if(strcmp(dumpPath, "-") == 0) {
+        hexes_latency_print(stderr);
+        return;
+    }
+    FILE* out = fopen(dumpPath, "w");
+    if(!out) return;
+    hexes_latency_print(out);
+    fclose(out);
+}
+
+static void check_env() {
+    if(checkedEnv) return;
+    checkedEnv = true;
+    dumpPath = getenv("TERMUTILS_LATENCY");
+    if(dumpPath && *dumpPath) atexit(dump);
+}
+
+// MARK: - Hooks
+
+void latency_input(int64_t time) {
+    if(pending < 0 || time < pending) pending = time;
+}
+
+void latency_presented(hexes_latency_source_t source) {
+    assert(source >= 0 && source < HEXES_LATENCY_SOURCES && "invalid latency source");
+    // Inside a caller's frame, nothing has reached the terminal yet.
+    if(pending < 0 || hexes_frame_active()) return;
+    check_env();
+    add_sample(&histograms[source], hexes_clock() - pending);
+    pending = -1;
+}
+
+// MARK: - Queries
+
+hexes_latency_t hexes_latency(hexes_latency_source_t source) {
+    assert(source >= 0 && source < HEXES_LATENCY_SOURCES && "invalid latency source");
+    const histogram_t* histogram = &histograms[source];
+    hexes_latency_t latency = {0, 0, 0, 0, 0};
+    if(!histogram->count) return latency;
+
+    latency.count = histogram->count;
+    latency.mean = (double)histogram->sum / histogram->count / 1000.0;
+    latency.p50 = percentile(histogram, 0.50) / 1000.0;
+    latency.p99 = percentile(histogram, 0.99) / 1000.0;
+    latency.max = histogram->max / 1000.0;
+    return latency;
+}
+
+void hexes_latency_reset() {
+    memset(histograms, 0, sizeof(histograms));
+    pending = -1;
+}
+
+void hexes_latency_print(FILE* out) {
+    static const char* names[HEXES_LATENCY_SOURCES] = {"line", "editor"};
+    for(int i = 0; i < HEXES_LATENCY_SOURCES; ++i) {
+        hexes_latency_t latency = hexes_latency(i);
+        if(!latency.count) continue;
+        fprintf(out, "%-8s %8ld samples  mean %8.3fms  p50 %8.3fms  p99 %8.3fms  max %8.3fms\n",
+                names[i], latency.count, latency.mean, latency.p50, latency.p99, latency.max);
+    }
+}
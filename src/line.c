@@ -8,7 +8,9 @@
 // =^•.•^=
 //===--------------------------------------------------------------------------------------------===
 #include <term/line.h>
+#include <term/backend.h>
 #include <term/hexes.h> // Could be moved back to private headers
+#include "instrument.h"
 #include "string_buf.h"
 #include <assert.h>
 #include <stdio.h>
@@ -34,7 +36,16 @@ struct line_t {
     
     line_functions_t functions;
     string_buf_t buffer;
+
+    // The text of the paste being handled. It is copied out of the input buffer, which checking
+    // for more input can reuse or move before the paste is inserted.
+    string_buf_t paste;
+
+    bool muted;     // Edits only update the buffer: the line gets redrawn in one go later.
+    bool dirty;     // What's on the terminal is out of date.
     
+    int historyCount;
+    size_t historyBytes;
     hist_entry_t* tail;
     hist_entry_t* head;
     hist_entry_t* current;
@@ -45,41 +56,60 @@ struct line_t {
 
 // MARK: - Terminal manipulation.
 
-static void put_char(char c) {
-    putchar(c);
+static void put_char(line_t* line, char c) {
+    if(!line->muted) hexes_putc(c);
 }
 
-static void put_string(const char* str) {
-    while(*str)
-        put_char(*str++);
+static void put_string(line_t* line, const char* str) {
+    if(!line->muted) hexes_puts(str);
 }
 
-static int show_char(line_t* line, char c) {
-    if(IS_CTL(c)) {
-        term_set_fg(stdout, TERM_BLACK);
-        put_char('^');
-        put_char(DE_CTL(c));
-        term_set_fg(stdout, TERM_DEFAULT);
-        return 2;
-    }
-    put_char(c & 0x7f);
-    return 1;
+static void put_escape(line_t* line, const char* sequence, term_escape_kind_t kind) {
+    (void)kind; // Only counted with TERMUTILS_STATS.
+    if(line->muted) return;
+    STATS_ESCAPE(kind);
+    hexes_puts(sequence);
 }
 
-static int show_string(line_t* line, const char* str) {
+// Shows control characters as ^X, greyed out. The colour only changes where a run of control
+// characters starts or ends, rather than around each of them.
+static int show_chars(line_t* line, const char* str, int count) {
     int total = 0;
-    while(*str)
-        total += show_char(line, *str++);
+    bool dim = false;
+    for(int i = 0; i < count; ++i) {
+        char c = str[i];
+        if(IS_CTL(c) != dim) {
+            dim = !dim;
+            if(!line->muted) term_set_fg(stdout, dim ? TERM_BLACK : TERM_DEFAULT);
+        }
+        if(dim) {
+            put_char(line, '^');
+            put_char(line, DE_CTL(c));
+            total += 2;
+        } else {
+            put_char(line, c & 0x7f);
+            total += 1;
+        }
+    }
+    if(dim && !line->muted) term_set_fg(stdout, TERM_DEFAULT);
     return total;
 }
 
+static int show_char(line_t* line, char c) {
+    return show_chars(line, &c, 1);
+}
+
+static int show_string(line_t* line, const char* str) {
+    return show_chars(line, str, strlen(str));
+}
+
 static void back(line_t* line, line_action_t mode) {
     if(mode == LINE_MOVE && !line->cursor) return;
     if(IS_CTL(line->buffer.data[line->cursor-1])) {
-        put_char('\b');
+        put_char(line, '\b');
     }
     if(mode == LINE_MOVE) line->cursor -= 1;
-    put_char('\b');
+    put_char(line, '\b');
 }
 
 static void back_n(line_t* line, line_action_t mode, int n) {
@@ -102,12 +132,15 @@ static void forward_n(line_t* line, int n) {
 
 // re-print the line after the cursor, to make sure we don't have any remaining stray characters.
 static line_cmd_t finish_line(line_t* line) {
+    TRACE_BEGIN("finish_line");
     int move = show_string(line, &line->buffer.data[line->cursor]);
-    put_string("\e[0K");
+    put_escape(line, "\e[0K", TERM_ESCAPE_ERASE);
+    TRACE_END("finish_line");
     return CMD(LINE_STAY, -move);
 }
 
 static line_cmd_t insert(line_t* line, int key) {
+    if(key < 0 || key > 0xff) return CMD_NOTHING; // Special keys we have no binding for
     string_buf_insert(&line->buffer, line->cursor, key & 0x00ff);
     show_char(line, key);
     line->cursor += 1;
@@ -115,6 +148,28 @@ static line_cmd_t insert(line_t* line, int key) {
     return finish_line(line);
 }
 
+static line_cmd_t paste(line_t* line, int key) {
+    const char* text = line->paste.data;
+    int length = line->paste.count;
+    if(!length) return CMD_NOTHING;
+
+    // A line has no line breaks: each pasted one (CR, LF or CRLF) becomes a space, so a multi-line
+    // paste comes back as one line, and is stored as one history entry.
+    int start = line->cursor;
+    string_buf_insert_n(&line->buffer, start, text, length);
+    char* inserted = &line->buffer.data[start];
+    int count = 0;
+    for(int i = 0; i < length; ++i) {
+        if(text[i] == '\r' && i + 1 < length && text[i + 1] == '\n') i += 1;
+        inserted[count++] = text[i] == '\r' || text[i] == '\n' ? ' ' : text[i];
+    }
+    if(count < length) string_buf_erase(&line->buffer, start + count, length - count);
+    line->cursor += count;
+    show_chars(line, inserted, count);
+    if(line->cursor == line->buffer.count) return CMD_NOTHING;
+    return finish_line(line);
+}
+
 static line_cmd_t backspace(line_t* line, int key) {
     if(!line->buffer.count || !line->cursor) return CMD_NOTHING;
     back(line, LINE_MOVE);
@@ -128,6 +183,14 @@ static line_cmd_t delete(line_t* line, int key) {
     return finish_line(line);
 }
 
+static line_cmd_t home(line_t* line, int key) {
+    return CMD(LINE_MOVE, -line->cursor);
+}
+
+static line_cmd_t end(line_t* line, int key) {
+    return CMD(LINE_MOVE, line->buffer.count - line->cursor);
+}
+
 static line_cmd_t ctrl_d(line_t *line, int key) {
     if(line->buffer.count) {
         return delete(line, key);
@@ -136,24 +199,46 @@ static line_cmd_t ctrl_d(line_t *line, int key) {
     }
 }
 
-static line_cmd_t clear(line_t* line, int key) {
-    line->cursor = 0;
-    line->buffer.count = 0;
-    if(line->buffer.capacity) line->buffer.data[0] = '\0';
-    return CMD(LINE_CANCEL, 0);
-}
-
 // MARK: - Built-in utils
 
 static void show_prompt(const line_t* line) {
+    if(line->muted) return;
     if(line->functions.print_prompt) {
+        // The printer is free to use stdio, which only stays in order with hexes outside of a
+        // frame. Other backends never see stdio output, so they keep the prompt in the frame.
+        bool terminal = hexes_get_backend() == hexes_terminal_backend();
+        int depth = terminal ? hexes_frame_suspend() : 0;
         line->functions.print_prompt(line->prompt);
+        if(terminal) hexes_frame_resume(depth);
     } else {
-        put_string(line->prompt);
-        put_string("> ");
+        hexes_puts(line->prompt);
+        hexes_puts("> ");
     }
 }
 
+// Redraws the prompt and the whole line, and puts the cursor back where it belongs.
+static void refresh(line_t* line) {
+    TRACE_BEGIN("refresh");
+    STATS_ESCAPE(TERM_ESCAPE_ERASE);
+    hexes_puts("\r\e[2K");
+    show_prompt(line);
+    show_string(line, line->buffer.data);
+
+    int width = 0;
+    for(int i = line->cursor; i < line->buffer.count; ++i)
+        width += IS_CTL(line->buffer.data[i]) ? 2 : 1;
+    if(width) hexes_cursor_left(width);
+    line->dirty = false;
+    TRACE_END("refresh");
+}
+
+static void render(void* data) {
+    hexes_frame_begin();
+    refresh(data);
+    hexes_frame_end();
+    latency_presented(HEXES_LATENCY_LINE);
+}
+
 static void reset(line_t* line) {
     line->buffer.count = 0;
     if(line->buffer.capacity) line->buffer.data[0] = '\0';
@@ -170,6 +255,8 @@ static void free_history(line_t* line) {
         free(entry);
         entry = prev;
     }
+    STATS_SUB(historyEntries, line->historyCount);
+    STATS_SUB(historyBytes, line->historyBytes);
 }
 
 static line_cmd_t history_prev(line_t* line, int key) {
@@ -206,18 +293,23 @@ static line_cmd_t history_next(line_t* line, int key) {
 
 static const binding_data_t bindings[] = {
     {CTL('d'),          &ctrl_d,        CMD_NOTHING},
-    {CTL('c'),          &clear,         CMD_NOTHING},
+    {CTL('c'),          NULL,           CMD(LINE_CANCEL, 0)},
     {CTL('m'),          NULL,           CMD(LINE_RETURN, 0)},
     {CTL('J'),          NULL,           CMD(LINE_RETURN, 0)},
     // {CTL('l'),          NULL,           CMD(LINE_REFRESH, 0)},
     
     {KEY_BACKSPACE,     &backspace,     CMD_NOTHING},
     {KEY_DELETE,        &delete,        CMD_NOTHING},
+    {KEY_PASTE,         &paste,         CMD_NOTHING},
     
     {CTL('b'),          NULL,           CMD(LINE_MOVE, -1)},
     {KEY_ARROW_LEFT,    NULL,           CMD(LINE_MOVE, -1)},
     {CTL('f'),          NULL,           CMD(LINE_MOVE, 1)},
     {KEY_ARROW_RIGHT,   NULL,           CMD(LINE_MOVE, 1)},
+    {CTL('a'),          &home,          CMD_NOTHING},
+    {KEY_HOME,          &home,          CMD_NOTHING},
+    {CTL('e'),          &end,           CMD_NOTHING},
+    {KEY_END,           &end,           CMD_NOTHING},
     
     {CTL('p'),          &history_prev,  CMD_NOTHING},
     {KEY_ARROW_UP,      &history_prev,  CMD_NOTHING},
@@ -227,15 +319,25 @@ static const binding_data_t bindings[] = {
     {0,                 NULL,           CMD_NOTHING},
 };
 
-static line_cmd_t dispatch(line_t* line, int key) {
-    
+static const binding_data_t* find_binding(int key) {
     for(int i = 0; bindings[i].key != 0; ++i) {
-        if(bindings[i].key != key) continue;
-        return bindings[i].function ?
-            bindings[i].function(line, key) :
-            bindings[i].default_cmd;
+        if(bindings[i].key == key) return &bindings[i];
     }
-    return insert(line, key);
+    return NULL;
+}
+
+static line_cmd_t dispatch(line_t* line, int key) {
+    TRACE_BEGIN("dispatch");
+    const binding_data_t* binding = find_binding(key);
+    line_cmd_t cmd;
+    if(!binding)
+        cmd = insert(line, key);
+    else if(binding->function)
+        cmd = binding->function(line, key);
+    else
+        cmd = binding->default_cmd;
+    TRACE_END("dispatch");
+    return cmd;
 }
 
 // MARK: - Public line_t API
@@ -249,6 +351,13 @@ line_t* line_new(const line_functions_t* functions) {
     line->functions = *functions;
     string_buf_init(&line->buffer);
     
+    string_buf_init(&line->paste);
+    line->muted = false;
+    line->dirty = false;
+
+    line->historyCount = 0;
+    line->historyBytes = 0;
+    line->tail = NULL;
     line->head = NULL;
     line->current = NULL;
     
@@ -258,6 +367,7 @@ line_t* line_new(const line_functions_t* functions) {
 void line_destroy(line_t* line) {
     assert(line && "cannot deallocate a null line");
     string_buf_fini(&line->buffer);
+    string_buf_fini(&line->paste);
     free_history(line);
     free(line);
 }
@@ -272,66 +382,139 @@ void line_set_prompt(line_t* line, const char* prompt) {
     strncpy(line->prompt, prompt, sizeof(line->prompt)-1);
 }
 
-char* line_get(line_t* line) {
+void line_start(line_t* line) {
+    assert(line && "cannot start editing with a null line editor");
     hexes_raw_start();
     reset(line);
-    
-    char* result = NULL;
-    put_string("\r\e[2K");
+
+    hexes_frame_begin();
+    hexes_set_bracketed_paste(true);
+    STATS_ESCAPE(TERM_ESCAPE_ERASE);
+    hexes_puts("\r\e[2K");
     show_prompt(line);
-    for(;;) {
-        int key = hexes_get_key_raw();
-        line_cmd_t cmd = dispatch(line, key);
-        
-        switch(cmd.action) {
-        case LINE_STAY:
-            if(cmd.param >= 0) break;
-            if(cmd.param < 0) back_n(line, LINE_STAY, -cmd.param);
-            break;
-            
-        case LINE_DONE:
-            show_char(line, key);
-            put_string("\r\n");
-            result = NULL;
-            goto done;
-            
-        case LINE_RETURN:
-            if(!line->buffer.count) {
-                put_string("\r\n");
-                show_prompt(line);
-            } else {
-                put_string("\n\r");
-                string_buf_append(&line->buffer, '\n');
-                result = string_buf_take(&line->buffer);
-                goto done;
-            }
-            break;
-            
-        case LINE_MOVE:
-            if(cmd.param < 0) back_n(line, LINE_MOVE, -cmd.param);
-            if(cmd.param > 0) forward_n(line, cmd.param);
-            break;
-            
-        case LINE_REFRESH:
-            put_string("\r\e[2K");
-            show_prompt(line);
-            show_string(line, line->buffer.data);
-            break;
-            
-        case LINE_CANCEL:
-            show_char(line, key);
-            put_string("\r\n");
-            show_prompt(line);
-            break;
-            
-        }
-    }
-    
-done:
+    hexes_frame_end();
+}
+
+static void finish(line_t* line, char* result) {
+    hexes_schedule_render(NULL, NULL);
+    hexes_set_bracketed_paste(false);
+    hexes_frame_end();
+    // Leaving raw mode waits for the terminal to take all of its output, which isn't on the key.
+    latency_presented(HEXES_LATENCY_LINE);
     hexes_raw_stop();
-    fflush(stdout);
     line->current = NULL;
     if(result) line_history_add(line, result);
+}
+
+line_action_t line_handle(line_t* line, const hexes_event_t* event, char** result) {
+    assert(line && "cannot handle events with a null line editor");
+    assert(result && "cannot return a line into a null pointer");
+    *result = NULL;
+
+    hexes_frame_begin();
+    if(!event) { // Standard input was closed
+        finish(line, NULL);
+        return LINE_DONE;
+    }
+    // Nothing is bound to Alt, and typing Alt+b as b would be wrong.
+    if((event->kind != HEXES_EVENT_KEY && event->kind != HEXES_EVENT_PASTE)
+       || (event->mods & HEXES_MOD_ALT)) {
+        hexes_frame_end();
+        return LINE_STAY;
+    }
+
+    int key = event->key;
+    line->paste.count = 0;
+    if(event->kind == HEXES_EVENT_PASTE && event->length)
+        string_buf_append_n(&line->paste, event->text, event->length);
+
+    // While more input is waiting, or before the frame interval is up, edits only change the
+    // buffer, and the line is redrawn once, when the event loop runs out of input.
+    bool defer = hexes_pending_events() || hexes_frame_delay();
+    line->muted = defer || line->dirty;
+    line_cmd_t cmd = dispatch(line, key);
+
+    if(cmd.action == LINE_DONE || cmd.action == LINE_RETURN || cmd.action == LINE_CANCEL) {
+        // These leave the line on the screen for good, so it has to be up to date first. None of
+        // them changed the buffer.
+        line->muted = false;
+        if(line->dirty) {
+            hexes_schedule_render(NULL, NULL);
+            refresh(line);
+        }
+    }
+
+    switch(cmd.action) {
+    case LINE_STAY:
+        if(cmd.param >= 0) break;
+        if(cmd.param < 0) back_n(line, LINE_STAY, -cmd.param);
+        break;
+
+    case LINE_DONE:
+        show_char(line, key);
+        put_string(line, "\r\n");
+        finish(line, NULL);
+        return LINE_DONE;
+
+    case LINE_RETURN:
+        if(!line->buffer.count) {
+            put_string(line, "\r\n");
+            show_prompt(line);
+        } else {
+            put_string(line, "\n\r");
+            string_buf_append(&line->buffer, '\n');
+            *result = string_buf_take(&line->buffer);
+            // Taking the text leaves no storage behind, and the next line draws from the buffer.
+            string_buf_init(&line->buffer);
+            finish(line, *result);
+            return LINE_RETURN;
+        }
+        break;
+
+    case LINE_MOVE:
+        if(cmd.param < 0) back_n(line, LINE_MOVE, -cmd.param);
+        if(cmd.param > 0) forward_n(line, cmd.param);
+        break;
+
+    case LINE_REFRESH:
+        if(!line->muted) refresh(line);
+        break;
+
+    case LINE_CANCEL:
+        show_char(line, key);
+        put_string(line, "\r\n");
+        reset(line);
+        show_prompt(line);
+        break;
+
+    }
+
+    if(line->muted) {
+        line->muted = false;
+        line->dirty = true;
+        if(defer) {
+            hexes_schedule_render(render, line);
+        } else {
+            hexes_schedule_render(NULL, NULL);
+            refresh(line);
+        }
+    }
+    hexes_frame_end();
+    // Deferred edits are measured when the scheduled render shows them.
+    if(!defer) latency_presented(HEXES_LATENCY_LINE);
+    return LINE_STAY;
+}
+
+char* line_get(line_t* line) {
+    line_start(line);
+
+    char* result = NULL;
+    hexes_event_t event;
+    for(;;) {
+        bool open = hexes_poll_event(&event, -1) > 0;
+        line_action_t action = line_handle(line, open ? &event : NULL, &result);
+        if(action == LINE_RETURN || action == LINE_DONE) break;
+    }
     return result;
 }
 
@@ -351,6 +534,7 @@ void line_history_load(line_t* line, const char* path) {
     
     FILE* history = fopen(path, "rb");
     if(!history) return;
+    TRACE_BEGIN("line_history_load");
     
     char* buffer = NULL;
     size_t size = 0;
@@ -361,11 +545,13 @@ void line_history_load(line_t* line, const char* path) {
     
     free(buffer);
     fclose(history);
+    TRACE_END("line_history_load");
 }
 
 void line_history_write(line_t* line, const char* path) {
     FILE* history = fopen(path, "wb");
     if(!history) return;
+    TRACE_BEGIN("line_history_write");
     
     hist_entry_t* entry = line->tail;
     while(entry) {
@@ -373,11 +559,13 @@ void line_history_write(line_t* line, const char* path) {
         entry = entry->next;
     }
     fclose(history);
+    TRACE_END("line_history_write");
 }
 
 void line_history_add(line_t* line, const char* data) {
     int length = strlen(data);
-    hist_entry_t* entry = malloc(sizeof(hist_entry_t) + (length + 1) * sizeof(char));
+    size_t size = sizeof(hist_entry_t) + (length + 1) * sizeof(char);
+    hist_entry_t* entry = malloc(size);
     memcpy(entry->line, data, length);
     entry->line[length] = '\0';
     strip(entry->line);
@@ -391,4 +579,15 @@ void line_history_add(line_t* line, const char* data) {
         line->tail = entry;
     }
     line->head = entry;
+
+    line->historyCount += 1;
+    line->historyBytes += size;
+    STATS_ADD(historyEntries, 1);
+    STATS_ADD(historyBytes, size);
+}
+
+int line_history_count(const line_t* line, size_t* bytes) {
+    assert(line && "cannot count the history of a null line editor");
+    if(bytes) *bytes = line->historyBytes;
+    return line->historyCount;
 }
@@ -0,0 +1,283 @@
+//===--------------------------------------------------------------------------------------------===
+// logger.c - log messages written out to stderr by a background thread
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#include <term/printing.h>
+#include "instrument.h"
+#include "logger.h"
+#include <stdio.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+// The queue between the logging threads and the writer. It must be a power of two.
+#define LOG_QUEUE_SIZE  256
+// How many messages the writer hands to a single writev() at most.
+#define LOG_BATCH       64
+// Buffers that grew past this are given back to the system once written, instead of being reused.
+#define LOG_MAX_KEEP    (16 * 1024)
+// How long the writer sleeps when there is nothing to write, in milliseconds.
+#define LOG_IDLE_WAIT   50
+
+// Any thread can log, so slots are claimed by moving the tail on with a compare-and-swap. Each
+// slot has a sequence number that says whose turn it is: a slot is free for the message numbered
+// [sequence], holds that message once [sequence] is one past it, and is free again for the next
+// lap of the queue once the writer has written it out. Messages are swapped into their slot
+// rather than copied, and the logging thread gets the slot's empty buffer to format the next one.
+//
+// Stopping switches [active] off, then waits until no thread is between its check of [active] and
+// the publication of its message, so that every message that got in is written out.
+typedef struct {
+    atomic_uint sequence;
+    string_buf_t data;
+} log_slot_t;
+
+static struct {
+    atomic_bool active;
+    atomic_int producers;
+    term_log_policy_t policy;
+
+    log_slot_t slots[LOG_QUEUE_SIZE];
+    atomic_uint head;
+    atomic_uint tail;
+    atomic_ulong dropped;
+    unsigned long reported;
+
+    atomic_bool stopping;
+    atomic_bool sleeping;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} logger = {
+    .active = false,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+};
+
+static void wake_writer() {
+    pthread_cond_signal(&logger.wake);
+}
+
+static void nap() {
+    nanosleep(&(struct timespec){0, 1000000L}, NULL);
+}
+
+// MARK: - Writer thread
+
+static void write_all(struct iovec* iov, int count) {
+    while(count > 0) {
+        ssize_t written = writev(STDERR_FILENO, iov, count);
+        if(written < 0) {
+            if(errno == EINTR) continue;
+            return;
+        }
+        STATS_ADD(bytes, written);
+        while(count > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov += 1;
+            count -= 1;
+        }
+        if(count > 0) {
+            iov->iov_base = (char*)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+}
+
+// Writes out everything that has been published so far, a batch at a time. Returns whether there
+// was anything to write.
+static bool drain() {
+    bool wrote = false;
+    for(;;) {
+        unsigned head = atomic_load_explicit(&logger.head, memory_order_relaxed);
+        struct iovec iov[LOG_BATCH + 1];
+        int count = 0;
+        while(count < LOG_BATCH) {
+            log_slot_t* slot = &logger.slots[(head + count) % LOG_QUEUE_SIZE];
+            unsigned sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+            if(sequence != head + count + 1) break;
+            iov[count++] = (struct iovec){slot->data.data, slot->data.count};
+        }
+
+        char note[64];
+        int batch = count;
+        unsigned long dropped = atomic_load_explicit(&logger.dropped, memory_order_relaxed);
+        if(logger.policy == TERM_LOG_COUNT && dropped != logger.reported) {
+            int length = snprintf(note, sizeof(note), "... %lu messages dropped\n",
+                                  dropped - logger.reported);
+            iov[count++] = (struct iovec){note, length};
+            logger.reported = dropped;
+        }
+        if(!count) return wrote;
+        write_all(iov, count);
+        wrote = true;
+
+        for(int i = 0; i < batch; ++i) {
+            log_slot_t* slot = &logger.slots[(head + i) % LOG_QUEUE_SIZE];
+            slot->data.count = 0;
+            if(slot->data.capacity > LOG_MAX_KEEP) string_buf_fini(&slot->data);
+            atomic_store_explicit(&slot->sequence, head + i + LOG_QUEUE_SIZE, memory_order_release);
+        }
+        atomic_store_explicit(&logger.head, head + batch, memory_order_release);
+    }
+}
+
+static void* writer(void* data) {
+    (void)data;
+    for(;;) {
+        bool stopping = atomic_load(&logger.stopping);
+        if(drain()) continue;
+        if(stopping) break;
+
+        // Loggers only signal the writer when it says it is asleep. A message published between
+        // the drain and the wait is picked up when the wait times out at the latest.
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_nsec += LOG_IDLE_WAIT * 1000000L;
+        if(until.tv_nsec >= 1000000000L) {
+            until.tv_sec += 1;
+            until.tv_nsec -= 1000000000L;
+        }
+        pthread_mutex_lock(&logger.lock);
+        atomic_store(&logger.sleeping, true);
+        if(!atomic_load(&logger.stopping))
+            pthread_cond_timedwait(&logger.wake, &logger.lock, &until);
+        atomic_store(&logger.sleeping, false);
+        pthread_mutex_unlock(&logger.lock);
+    }
+    return NULL;
+}
+
+// MARK: - Logging
+
+// Claims the next slot and publishes [message] in it, or drops it if the queue is full.
+static bool push(string_buf_t* message, bool wait) {
+    unsigned tail = atomic_load_explicit(&logger.tail, memory_order_relaxed);
+    log_slot_t* slot;
+    for(;;) {
+        slot = &logger.slots[tail % LOG_QUEUE_SIZE];
+        unsigned sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int lap = (int)(sequence - tail);
+        if(lap == 0) {
+            if(atomic_compare_exchange_weak_explicit(&logger.tail, &tail, tail + 1,
+                                                     memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if(lap < 0) {
+            // The writer is a whole queue behind.
+            if(!wait && logger.policy != TERM_LOG_BLOCK) {
+                atomic_fetch_add_explicit(&logger.dropped, 1, memory_order_relaxed);
+                message->count = 0;
+                return true;
+            }
+            wake_writer();
+            nap();
+            tail = atomic_load_explicit(&logger.tail, memory_order_relaxed);
+        } else {
+            // Another thread claimed the slot first.
+            tail = atomic_load_explicit(&logger.tail, memory_order_relaxed);
+        }
+    }
+
+    string_buf_t taken = *message;
+    *message = slot->data;
+    message->count = 0;
+    slot->data = taken;
+    atomic_store_explicit(&slot->sequence, tail + 1, memory_order_release);
+    if(atomic_load_explicit(&logger.sleeping, memory_order_relaxed)) wake_writer();
+    return true;
+}
+
+bool logger_push(string_buf_t* message, bool wait) {
+    // Announcing the thread before checking [active] means that term_log_stop() either sees it, or
+    // stopped the logger before the check.
+    atomic_fetch_add(&logger.producers, 1);
+    bool queued = atomic_load(&logger.active) && push(message, wait);
+    atomic_fetch_sub_explicit(&logger.producers, 1, memory_order_release);
+    return queued;
+}
+
+bool term_log_start(term_log_policy_t full) {
+    static bool registered = false;
+    if(atomic_load(&logger.active)) return false;
+
+    // Whatever stdio still holds for stderr has to come before the first message.
+    fflush(stderr);
+    logger.policy = full;
+    for(unsigned i = 0; i < LOG_QUEUE_SIZE; ++i) {
+        atomic_store(&logger.slots[i].sequence, i);
+    }
+    atomic_store(&logger.head, 0);
+    atomic_store(&logger.tail, 0);
+    atomic_store(&logger.dropped, 0);
+    logger.reported = 0;
+    atomic_store(&logger.stopping, false);
+    atomic_store(&logger.sleeping, false);
+    if(pthread_create(&logger.thread, NULL, writer, NULL) != 0) return false;
+    atomic_store_explicit(&logger.active, true, memory_order_release);
+
+    if(!registered) {
+        atexit(term_log_stop);
+        registered = true;
+    }
+    return true;
+}
+
+void term_log_flush() {
+    if(!atomic_load(&logger.active)) return;
+    unsigned tail = atomic_load_explicit(&logger.tail, memory_order_acquire);
+    while((int)(atomic_load_explicit(&logger.head, memory_order_acquire) - tail) < 0) {
+        wake_writer();
+        nap();
+    }
+}
+
+void term_log_stop() {
+    if(!atomic_exchange(&logger.active, false)) return;
+    while(atomic_load_explicit(&logger.producers, memory_order_acquire)) nap();
+
+    pthread_mutex_lock(&logger.lock);
+    atomic_store(&logger.stopping, true);
+    pthread_cond_signal(&logger.wake);
+    pthread_mutex_unlock(&logger.lock);
+    pthread_join(logger.thread, NULL);
+}
+
+unsigned long term_log_dropped() {
+    return atomic_load_explicit(&logger.dropped, memory_order_relaxed);
+}
+
+#else
+
+bool logger_push(string_buf_t* message, bool wait) {
+    (void)message;
+    (void)wait;
+    return false;
+}
+
+bool term_log_start(term_log_policy_t full) {
+    (void)full;
+    return false;
+}
+
+void term_log_flush() {
+}
+
+void term_log_stop() {
+}
+
+unsigned long term_log_dropped() {
+    return 0;
+}
+
+#endif
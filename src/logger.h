@@ -0,0 +1,20 @@
+//===--------------------------------------------------------------------------------------------===
+// logger.h - hands log messages over to a background writer
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef term_logger_h
+#define term_logger_h
+#include "string_buf.h"
+#include <stdbool.h>
+
+/// Queues [message] for the writer thread. The logger takes the message's buffer, and leaves an
+/// empty one in its place. If [wait] is true, the message is never dropped, whatever the policy.
+/// Returns false, leaving [message] alone, when messages aren't written in the background.
+bool logger_push(string_buf_t* message, bool wait);
+
+#endif
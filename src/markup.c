@@ -0,0 +1,256 @@
+//===--------------------------------------------------------------------------------------------===
+// markup.c - styled output from precompiled markup templates
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#include <term/markup.h>
+#include <term/colors.h>
+#include "csi.h"
+#include "instrument.h"
+#include "string_buf.h"
+#include "style.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Templates that print this much or less are formatted on the stack.
+#define MARKUP_STACK_SIZE 512
+
+// Tags are compiled into the format string, so printing a template is one vsnprintf. The first
+// sequence depends on what we know of the stream: when it is known to be in the default style,
+// the template doesn't need to reset it first. We keep a format for either case.
+struct term_markup_s {
+    FILE* term;
+    char* source;
+
+    bool colors;
+    term_palette_t palette;
+    bool styled;            // Whether there are any escape sequences in the formats.
+    int escapes;            // How many there are in each, for the counters.
+    int cleanEscapes;
+    string_buf_t format;    // For a stream in an unknown style.
+    string_buf_t clean;     // For a stream in the default style.
+};
+
+static const char* colorNames[] = {
+    [TERM_BLACK] = "black",
+    [TERM_RED] = "red",
+    [TERM_GREEN] = "green",
+    [TERM_YELLOW] = "yellow",
+    [TERM_BLUE] = "blue",
+    [TERM_MAGENTA] = "magenta",
+    [TERM_CYAN] = "cyan",
+    [TERM_WHITE] = "white",
+    [TERM_DEFAULT] = "default",
+    [TERM_BRIGHT_BLACK] = "bright_black",
+    [TERM_BRIGHT_RED] = "bright_red",
+    [TERM_BRIGHT_GREEN] = "bright_green",
+    [TERM_BRIGHT_YELLOW] = "bright_yellow",
+    [TERM_BRIGHT_BLUE] = "bright_blue",
+    [TERM_BRIGHT_MAGENTA] = "bright_magenta",
+    [TERM_BRIGHT_CYAN] = "bright_cyan",
+    [TERM_BRIGHT_WHITE] = "bright_white",
+};
+
+// MARK: - Tags
+
+static bool matches(const char* tag, int length, const char* name) {
+    return (int)strlen(name) == length && !strncmp(tag, name, length);
+}
+
+static int hex_digit(char c) {
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool parse_color(const char* tag, int length, term_color_t* color) {
+    if(length == 7 && tag[0] == '#') {
+        int rgb = 0;
+        for(int i = 1; i < 7; ++i) {
+            int digit = hex_digit(tag[i]);
+            if(digit < 0) return false;
+            rgb = rgb << 4 | digit;
+        }
+        *color = TERM_RGB(rgb >> 16, rgb >> 8, rgb);
+        return true;
+    }
+
+    if(length > 0 && length <= 3 && tag[0] >= '0' && tag[0] <= '9') {
+        int index = 0;
+        for(int i = 0; i < length; ++i) {
+            if(tag[i] < '0' || tag[i] > '9') return false;
+            index = index * 10 + tag[i] - '0';
+        }
+        if(index > 255) return false;
+        *color = TERM_INDEXED(index);
+        return true;
+    }
+
+    for(int i = 0; i < TERM_INVALID_COLOR; ++i) {
+        if(!matches(tag, length, colorNames[i])) continue;
+        *color = i;
+        return true;
+    }
+    return false;
+}
+
+static bool apply_tag(term_style_t* style, const char* tag, int length) {
+    if(matches(tag, length, "/")) {
+        *style = TERM_STYLE_DEFAULT;
+    } else if(matches(tag, length, "bold")) {
+        style->bold = true;
+    } else if(matches(tag, length, "underline")) {
+        style->underline = true;
+    } else if(matches(tag, length, "reverse")) {
+        style->reverse = true;
+    } else if(length > 3 && !strncmp(tag, "bg:", 3)) {
+        return parse_color(tag + 3, length - 3, &style->bg);
+    } else {
+        return parse_color(tag, length, &style->fg);
+    }
+    return true;
+}
+
+// MARK: - Compiling
+
+typedef struct {
+    term_palette_t palette;
+    string_buf_t* out;
+    term_style_t shown;
+    bool known;
+    int escapes;
+} compiler_t;
+
+// Brings the stream to [style] before more text is printed.
+static void flush(compiler_t* compiler, term_style_t style) {
+    char buffer[CSI_MAX_LENGTH];
+    const term_style_t* from = compiler->known ? &compiler->shown : NULL;
+    int length = style_encode(buffer, compiler->palette, from, style);
+    if(length) {
+        string_buf_append_n(compiler->out, buffer, length);
+        compiler->escapes += 1;
+    }
+    compiler->shown = style;
+    compiler->known = true;
+}
+
+// Compiles [source] into [out]. With [colors] off, tags are checked and dropped.
+static bool compile(const char* source, string_buf_t* out, bool colors, term_palette_t palette,
+                    bool clean, int* escapes) {
+    compiler_t compiler = {palette, out, TERM_STYLE_DEFAULT, clean, 0};
+    term_style_t style = TERM_STYLE_DEFAULT;
+    bool dirty = colors && !clean;
+
+    out->count = 0;
+    out->data[0] = '\0';
+    for(const char* str = source; *str;) {
+        if(str[0] == '{' && str[1] != '{') {
+            const char* end = strchr(str, '}');
+            if(!end || !apply_tag(&style, str + 1, end - str - 1)) return false;
+            dirty = colors;
+            str = end + 1;
+            continue;
+        }
+        if(dirty) {
+            flush(&compiler, style);
+            dirty = false;
+        }
+        string_buf_append(out, *str);
+        str += str[0] == '{' ? 2 : 1;
+    }
+    if(dirty || (colors && compiler.known)) flush(&compiler, TERM_STYLE_DEFAULT);
+    *escapes = compiler.escapes;
+    return true;
+}
+
+static bool has_tags(const char* source) {
+    for(const char* str = strchr(source, '{'); str; str = strchr(str + 2, '{')) {
+        if(str[1] != '{') return true;
+    }
+    return false;
+}
+
+static bool build(term_markup_t* markup) {
+    markup->colors = term_has_colors(markup->term);
+    markup->palette = term_palette(markup->term);
+    markup->styled = markup->colors && has_tags(markup->source);
+
+    if(!compile(markup->source, &markup->format, markup->styled, markup->palette, false,
+                &markup->escapes)
+       || !compile(markup->source, &markup->clean, markup->styled, markup->palette, true,
+                   &markup->cleanEscapes)) {
+        return false;
+    }
+    return true;
+}
+
+term_markup_t* term_markup_new(FILE* term, const char* markup) {
+    assert(term && "cannot compile markup for a null stream");
+    assert(markup && "cannot compile null markup");
+
+    term_markup_t* compiled = malloc(sizeof(term_markup_t));
+    compiled->term = term;
+    compiled->source = strdup(markup);
+    string_buf_init(&compiled->format);
+    string_buf_init(&compiled->clean);
+    if(!build(compiled)) {
+        term_markup_destroy(compiled);
+        return NULL;
+    }
+    return compiled;
+}
+
+void term_markup_destroy(term_markup_t* markup) {
+    if(!markup) return;
+    string_buf_fini(&markup->format);
+    string_buf_fini(&markup->clean);
+    free(markup->source);
+    free(markup);
+}
+
+// MARK: - Printing
+
+int term_markup_vprint(term_markup_t* markup, va_list args) {
+    assert(markup && "cannot print null markup");
+    if(markup->colors != term_has_colors(markup->term)
+       || markup->palette != term_palette(markup->term)) {
+        build(markup);
+    }
+
+    bool clean = markup->styled && style_is_default(markup->term);
+    const char* format = clean ? markup->clean.data : markup->format.data;
+
+    char stack[MARKUP_STACK_SIZE];
+    char* buffer = stack;
+    va_list copy;
+    va_copy(copy, args);
+    int length = vsnprintf(stack, sizeof(stack), format, args);
+    if(length >= (int)sizeof(stack)) {
+        buffer = malloc(length + 1);
+        vsnprintf(buffer, length + 1, format, copy);
+    }
+    va_end(copy);
+
+    if(length > 0) style_write(markup->term, buffer, length);
+    if(buffer != stack) free(buffer);
+
+    if(markup->styled) {
+        STATS_ADD(escapes[TERM_ESCAPE_SGR], clean ? markup->cleanEscapes : markup->escapes);
+        style_assume(markup->term, TERM_STYLE_DEFAULT);
+    }
+    return length;
+}
+
+int term_markup_print(term_markup_t* markup, ...) {
+    va_list args;
+    va_start(args, markup);
+    int length = term_markup_vprint(markup, args);
+    va_end(args);
+    return length;
+}
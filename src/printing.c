@@ -9,9 +9,21 @@
 //===--------------------------------------------------------------------------------------------===
 #include <term/printing.h>
 #include <term/colors.h>
+#include "csi.h"
+#include "logger.h"
+#include "string_buf.h"
+#include "style.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+// Message buffers that grew past this are given back to the system, instead of being reused.
+#define MESSAGE_MAX_KEEP (16 * 1024)
 
 static term_filter_t level__ = TERM_WARN;
 
@@ -19,51 +31,117 @@ void term_set_filter(term_filter_t minimum) {
     level__ = minimum;
 }
 
-static inline void print_preamble(const char* program, const char* what, term_color_t color) {
-    term_style_reset(stderr);
-    fprintf(stderr, "%s: ", program);
-    term_set_bold(stderr, true);
-    term_set_fg(stderr, color);
-    fprintf(stderr, "%s:", what);
-    term_style_reset(stderr);
-    fprintf(stderr, " ");
+static const struct {
+    const char* label;
+    term_style_t style;
+} preambles[] = {
+    [TERM_INFO] = {"info:", {TERM_DEFAULT, TERM_DEFAULT, true, false, false}},
+    [TERM_WARN] = {"warning:", {TERM_MAGENTA, TERM_DEFAULT, true, false, false}},
+    [TERM_ERROR] = {"error:", {TERM_RED, TERM_DEFAULT, true, false, false}},
+};
+
+// Each message is formatted here in full, then written out with a single call, so that messages
+// logged from different threads don't cut into each other. With the background writer running,
+// the buffer is traded for an empty one from its queue.
+static _Thread_local string_buf_t message = {0, 0, NULL};
+
+#ifndef _WIN32
+static pthread_key_t messageKey;
+static pthread_once_t messageOnce = PTHREAD_ONCE_INIT;
+
+static void free_message(void* data) {
+    string_buf_fini(data);
+}
+
+static void make_message_key() {
+    pthread_key_create(&messageKey, free_message);
+}
+
+// Threads that log get their buffer freed when they exit.
+static void register_message() {
+    pthread_once(&messageOnce, make_message_key);
+    pthread_setspecific(messageKey, &message);
+}
+#else
+static void register_message() {
+}
+#endif
+
+// The preamble doesn't depend on what style the stream was left in: it starts from a reset and
+// ends with one, so it reads the same whenever and from whichever thread it gets written out.
+static void append_preamble(const char* program, term_filter_t level) {
+    const char* label = preambles[level].label;
+    term_style_t style = preambles[level].style;
+    bool colors = term_has_colors(stderr);
+    term_palette_t palette = term_palette(stderr);
+    char sgr[CSI_MAX_LENGTH];
+
+    string_buf_append_n(&message, program, strlen(program));
+    string_buf_append_n(&message, ": ", 2);
+    if(colors) string_buf_append_n(&message, sgr, style_change(sgr, palette, NULL, style));
+    string_buf_append_n(&message, label, strlen(label));
+    if(colors) {
+        string_buf_append_n(&message, sgr, style_change(sgr, palette, &style, TERM_STYLE_DEFAULT));
+    }
+    string_buf_append_n(&message, " ", 1);
+}
+
+static void log_message(const char* program, term_filter_t level, bool fatal,
+                        const char* format, va_list args) {
+    if(!message.data) register_message();
+    message.count = 0;
+    append_preamble(program, level);
+
+    va_list copy;
+    va_copy(copy, args);
+    int room = message.capacity - message.count;
+    int length = vsnprintf(message.data + message.count, room, format, args);
+    if(length >= room) {
+        string_buf_ensure(&message, message.count + length);
+        vsnprintf(message.data + message.count, length + 1, format, copy);
+    }
+    va_end(copy);
+    if(length > 0) message.count += length;
+    string_buf_append(&message, '\n');
+
+    if(!logger_push(&message, fatal)) {
+        style_write(stderr, message.data, message.count);
+    } else if(fatal) {
+        term_log_flush();
+    }
+    // The preamble leaves stderr in the default style, whatever it was set to before.
+    term_style_invalidate(stderr);
+    if(message.capacity > MESSAGE_MAX_KEEP) string_buf_fini(&message);
 }
 
 /// Reports an error to [stderr] with the given format string.
 /// If [code] is not 0, exit(code) will be called.
 void term_error(const char* program, int code, const char* format, ...) {
-    print_preamble(program, "error", TERM_RED);
     va_list args;
     va_start(args, format);
-    vfprintf(stderr, format, args);
+    log_message(program, TERM_ERROR, code != 0, format, args);
     va_end(args);
-    fputc('\n', stderr);
     if(code) exit(code);
 }
 
 void term_warn(const char* program, const char* format, ...) {
     if(level__ > TERM_WARN) return;
-    print_preamble(program, "warning", TERM_MAGENTA);
     va_list args;
     va_start(args, format);
-    vfprintf(stderr, format, args);
+    log_message(program, TERM_WARN, false, format, args);
     va_end(args);
-    fputc('\n', stderr);
 }
 
 void term_info(const char* program, const char* format, ...) {
     if(level__ > TERM_INFO) return;
-    print_preamble(program, "info", TERM_DEFAULT);
     va_list args;
     va_start(args, format);
-    vfprintf(stderr, format, args);
+    log_message(program, TERM_INFO, false, format, args);
     va_end(args);
-    fputc('\n', stderr);
 }
 
 void term_print_usage(FILE* out, const char* program, const char** uses, int count) {
-    term_style_reset(out);
-    term_set_bold(out, true);
+    term_set_style(out, (term_style_t){TERM_DEFAULT, TERM_DEFAULT, true, false, false});
     fprintf(out, "Usage: ");
     term_style_reset(out);
     for(int i = 0; i < count; ++i) {
@@ -0,0 +1,335 @@
+//===--------------------------------------------------------------------------------------------===
+// record.c - asciicast session recorder, written out by a background thread
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#include <term/record.h>
+#include <term/hexes.h>
+#include "recorder.h"
+#include "string_buf.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+// The queue between the program and the writer thread. It must be a power of two.
+#define RECORD_QUEUE_SIZE   1024
+// Buffers that grew past this are given back to the system once written, instead of being reused.
+#define RECORD_MAX_KEEP     (64 * 1024)
+// How long the writer sleeps when there is nothing to write, in milliseconds.
+#define RECORD_IDLE_WAIT    50
+
+// Each slot owns its buffer. The program fills the slot at the tail and publishes it; the writer
+// writes out the slot at the head, empties it, and hands it back. Frames are swapped into a slot
+// rather than copied, and the frame gets the slot's empty buffer to draw the next one into.
+//
+// There is a single producer (the thread doing terminal I/O) and a single consumer (the writer),
+// so the two indices are all the synchronisation the queue needs.
+typedef struct {
+    int64_t time;
+    char kind;
+    string_buf_t data;
+} record_entry_t;
+
+static struct {
+    bool active;
+    bool input;
+    int64_t start;
+    FILE* out;
+
+    record_entry_t entries[RECORD_QUEUE_SIZE];
+    atomic_uint head;
+    atomic_uint tail;
+
+    atomic_bool stopping;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} rec = {
+    .active = false,
+    .out = NULL,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+};
+
+static int64_t now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void wake_writer() {
+    pthread_cond_signal(&rec.wake);
+}
+
+// MARK: - Writer thread
+
+static void append_escape(string_buf_t* out, unsigned code) {
+    char escape[8];
+    snprintf(escape, sizeof(escape), "\\u%04x", code);
+    string_buf_append_n(out, escape, 6);
+}
+
+// Returns the length of the UTF-8 sequence at the start of [data], or 0 if it isn't a valid one.
+static int utf8_length(const uint8_t* data, int length) {
+    int count = data[0] >= 0xf0 && data[0] < 0xf5 ? 4
+        : data[0] >= 0xe0 ? 3
+        : data[0] >= 0xc2 && data[0] < 0xe0 ? 2
+        : 0;
+    if(!count || count > length) return 0;
+    for(int i = 1; i < count; ++i) {
+        if((data[i] & 0xc0) != 0x80) return 0;
+    }
+    return count;
+}
+
+// Appends [data] as a JSON string. Bytes that aren't valid UTF-8 become U+FFFD, which is what
+// asciinema does with them too.
+static void append_string(string_buf_t* out, const char* data, int length) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    string_buf_append(out, '"');
+    for(int i = 0; i < length;) {
+        uint8_t c = bytes[i];
+        if(c >= 0x80) {
+            int count = utf8_length(bytes + i, length - i);
+            if(count) {
+                string_buf_append_n(out, data + i, count);
+                i += count;
+            } else {
+                append_escape(out, 0xfffd);
+                i += 1;
+            }
+            continue;
+        }
+
+        switch(c) {
+        case '"': string_buf_append_n(out, "\\\"", 2); break;
+        case '\\': string_buf_append_n(out, "\\\\", 2); break;
+        case '\n': string_buf_append_n(out, "\\n", 2); break;
+        case '\r': string_buf_append_n(out, "\\r", 2); break;
+        case '\t': string_buf_append_n(out, "\\t", 2); break;
+        default:
+            if(c < 0x20 || c == 0x7f)
+                append_escape(out, c);
+            else
+                string_buf_append(out, c);
+            break;
+        }
+        i += 1;
+    }
+    string_buf_append(out, '"');
+}
+
+static void write_entry(string_buf_t* out, const record_entry_t* entry) {
+    char prefix[48];
+    int length = snprintf(prefix, sizeof(prefix), "[%.6f, \"%c\", ",
+                          (double)entry->time / 1e6, entry->kind);
+    string_buf_append_n(out, prefix, length);
+    append_string(out, entry->data.data, entry->data.count);
+    string_buf_append_n(out, "]\n", 2);
+}
+
+// Writes out everything that has been published so far.
+static void drain(string_buf_t* out) {
+    unsigned head = atomic_load_explicit(&rec.head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&rec.tail, memory_order_acquire);
+    if(head == tail) return;
+
+    for(; head != tail; ++head) {
+        record_entry_t* entry = &rec.entries[head % RECORD_QUEUE_SIZE];
+        write_entry(out, entry);
+        entry->data.count = 0;
+        if(entry->data.capacity > RECORD_MAX_KEEP) string_buf_fini(&entry->data);
+        atomic_store_explicit(&rec.head, head + 1, memory_order_release);
+    }
+    fwrite(out->data, 1, out->count, rec.out);
+    fflush(rec.out);
+    out->count = 0;
+}
+
+static void* writer(void* data) {
+    (void)data;
+    string_buf_t out;
+    string_buf_init(&out);
+
+    for(;;) {
+        bool stopping = atomic_load(&rec.stopping);
+        drain(&out);
+        if(stopping) break;
+
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_nsec += RECORD_IDLE_WAIT * 1000000L;
+        if(until.tv_nsec >= 1000000000L) {
+            until.tv_sec += 1;
+            until.tv_nsec -= 1000000000L;
+        }
+        pthread_mutex_lock(&rec.lock);
+        if(!atomic_load(&rec.stopping)) pthread_cond_timedwait(&rec.wake, &rec.lock, &until);
+        pthread_mutex_unlock(&rec.lock);
+    }
+    string_buf_fini(&out);
+    return NULL;
+}
+
+// MARK: - Recording
+
+// Returns the slot at the tail of the queue. When the writer has fallen a whole queue behind, we
+// wait for it: a recording with a hole in it doesn't replay to the same screen.
+static record_entry_t* reserve() {
+    unsigned tail = atomic_load_explicit(&rec.tail, memory_order_relaxed);
+    while(tail - atomic_load_explicit(&rec.head, memory_order_acquire) == RECORD_QUEUE_SIZE) {
+        wake_writer();
+        nanosleep(&(struct timespec){0, 1000000L}, NULL);
+    }
+    return &rec.entries[tail % RECORD_QUEUE_SIZE];
+}
+
+static void publish(record_entry_t* entry, char kind) {
+    entry->time = now_us() - rec.start;
+    entry->kind = kind;
+    unsigned tail = atomic_load_explicit(&rec.tail, memory_order_relaxed) + 1;
+    atomic_store_explicit(&rec.tail, tail, memory_order_release);
+    // The writer checks in on its own every so often: we only nudge it when the queue fills up.
+    if(tail - atomic_load_explicit(&rec.head, memory_order_relaxed) == RECORD_QUEUE_SIZE / 2)
+        wake_writer();
+}
+
+static void record_copy(char kind, const char* data, int length) {
+    record_entry_t* entry = reserve();
+    entry->data.count = 0;
+    string_buf_append_n(&entry->data, data, length);
+    publish(entry, kind);
+}
+
+void record_frame(string_buf_t* frame) {
+    if(!rec.active) return;
+    record_entry_t* entry = reserve();
+    string_buf_t taken = *frame;
+    *frame = entry->data;
+    frame->count = 0;
+    entry->data = taken;
+    publish(entry, 'o');
+}
+
+void record_output(const char* data, int length) {
+    if(!rec.active || length <= 0) return;
+    record_copy('o', data, length);
+}
+
+void record_input(const char* data, int length) {
+    if(!rec.active || !rec.input || length <= 0) return;
+    record_copy('i', data, length);
+}
+
+void record_resize(int width, int height) {
+    if(!rec.active) return;
+    char size[32];
+    record_copy('r', size, snprintf(size, sizeof(size), "%dx%d", width, height));
+}
+
+bool hexes_record_start(const char* path, bool input) {
+    assert(path && "cannot record to a null path");
+    static bool registered = false;
+    if(rec.active) return false;
+
+    FILE* out = fopen(path, "w");
+    if(!out) return false;
+
+    int width = 80, height = 24;
+    hexes_get_size(&width, &height);
+    const char* term = getenv("TERM");
+    string_buf_t header;
+    string_buf_init(&header);
+    char start[128];
+    int length = snprintf(start, sizeof(start),
+                          "{\"version\": 2, \"width\": %d, \"height\": %d, \"timestamp\": %lld",
+                          width, height, (long long)time(NULL));
+    string_buf_append_n(&header, start, length);
+    if(term) {
+        string_buf_append_n(&header, ", \"env\": {\"TERM\": ", 18);
+        append_string(&header, term, strlen(term));
+        string_buf_append(&header, '}');
+    }
+    string_buf_append_n(&header, "}\n", 2);
+    fwrite(header.data, 1, header.count, out);
+    string_buf_fini(&header);
+
+    rec.out = out;
+    rec.input = input;
+    rec.start = now_us();
+    atomic_store(&rec.head, 0);
+    atomic_store(&rec.tail, 0);
+    atomic_store(&rec.stopping, false);
+    if(pthread_create(&rec.thread, NULL, writer, NULL) != 0) {
+        fclose(out);
+        rec.out = NULL;
+        return false;
+    }
+    rec.active = true;
+
+    if(!registered) {
+        atexit(hexes_record_stop);
+        registered = true;
+    }
+    return true;
+}
+
+void hexes_record_stop() {
+    if(!rec.active) return;
+    rec.active = false;
+
+    pthread_mutex_lock(&rec.lock);
+    atomic_store(&rec.stopping, true);
+    pthread_cond_signal(&rec.wake);
+    pthread_mutex_unlock(&rec.lock);
+    pthread_join(rec.thread, NULL);
+
+    fclose(rec.out);
+    rec.out = NULL;
+    for(int i = 0; i < RECORD_QUEUE_SIZE; ++i) {
+        string_buf_fini(&rec.entries[i].data);
+    }
+}
+
+bool hexes_recording() {
+    return rec.active;
+}
+
+#else
+
+void record_frame(string_buf_t* frame) {
+    (void)frame;
+}
+
+void record_output(const char* data, int length) {
+}
+
+void record_input(const char* data, int length) {
+}
+
+void record_resize(int width, int height) {
+}
+
+bool hexes_record_start(const char* path, bool input) {
+    return false;
+}
+
+void hexes_record_stop() {
+}
+
+bool hexes_recording() {
+    return false;
+}
+
+#endif
@@ -0,0 +1,24 @@
+//===--------------------------------------------------------------------------------------------===
+// recorder.h - hooks through which hexes feeds the session recorder
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef term_recorder_h
+#define term_recorder_h
+#include "string_buf.h"
+
+/// Records a frame that was just written out. The recorder takes the frame's buffer, and leaves an
+/// empty one in its place.
+void record_frame(string_buf_t* frame);
+/// Records output written outside of a frame.
+void record_output(const char* data, int length);
+/// Records bytes read from the terminal, if the recording includes input.
+void record_input(const char* data, int length);
+/// Records the terminal changing size.
+void record_resize(int width, int height);
+
+#endif
@@ -0,0 +1,21 @@
+//===--------------------------------------------------------------------------------------------===
+// resize.h - private interface between the terminal size cache and the event loop
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef term_resize_h
+#define term_resize_h
+
+#ifndef _WIN32
+/// Installs the SIGWINCH handler, if it isn't already. Returns the read end of the pipe the handler
+/// writes to whenever the terminal is resized, or -1 if it couldn't be created.
+int resize_watch();
+/// Empties the resize pipe, once poll() has reported it readable.
+void resize_drain();
+#endif
+
+#endif
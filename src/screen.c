@@ -0,0 +1,276 @@
+//===--------------------------------------------------------------------------------------------===
+// screen.c - double-buffered cell grid and diff renderer
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#include <term/screen.h>
+#include <term/hexes.h>
+#include "csi.h"
+#include "string_buf.h"
+#include "style.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Runs of changed cells separated by up to this many unchanged cells are sent as one run: reprinting
+// a few cells is cheaper than a cursor movement sequence.
+#define SCREEN_MAX_GAP 4
+
+struct hexes_screen_s {
+    int width;
+    int height;
+    hexes_cell_t* front;
+    hexes_cell_t* back;
+
+    bool invalid;
+    int cursorX, cursorY;
+
+    string_buf_t scrolls;   // Scroll sequences to send before the next diff.
+};
+
+static const hexes_cell_t blank = {' ', {TERM_DEFAULT, TERM_DEFAULT, 0}};
+
+static inline bool same_style(hexes_style_t a, hexes_style_t b) {
+    return a.fg == b.fg && a.bg == b.bg && a.attrs == b.attrs;
+}
+
+static inline bool same_cell(const hexes_cell_t* a, const hexes_cell_t* b) {
+    return a->glyph == b->glyph && same_style(a->style, b->style);
+}
+
+static void fill_cells(hexes_cell_t* cells, int count) {
+    for(int i = 0; i < count; ++i) cells[i] = blank;
+}
+
+hexes_screen_t* hexes_screen_new(int width, int height) {
+    hexes_screen_t* screen = malloc(sizeof(hexes_screen_t));
+    assert(screen && "screen allocation failed");
+    screen->width = 0;
+    screen->height = 0;
+    screen->front = NULL;
+    screen->back = NULL;
+    screen->cursorX = 0;
+    screen->cursorY = 0;
+    string_buf_init(&screen->scrolls);
+    hexes_screen_resize(screen, width, height);
+    return screen;
+}
+
+void hexes_screen_destroy(hexes_screen_t* screen) {
+    assert(screen && "cannot destroy a null screen");
+    free(screen->front);
+    free(screen->back);
+    string_buf_fini(&screen->scrolls);
+    free(screen);
+}
+
+void hexes_screen_resize(hexes_screen_t* screen, int width, int height) {
+    assert(screen && "cannot resize a null screen");
+    if(width < 0) width = 0;
+    if(height < 0) height = 0;
+    screen->width = width;
+    screen->height = height;
+    screen->front = realloc(screen->front, width * height * sizeof(hexes_cell_t));
+    screen->back = realloc(screen->back, width * height * sizeof(hexes_cell_t));
+    fill_cells(screen->back, width * height);
+    hexes_screen_invalidate(screen);
+}
+
+void hexes_screen_invalidate(hexes_screen_t* screen) {
+    screen->invalid = true;
+    screen->scrolls.count = 0;
+}
+
+int hexes_screen_width(const hexes_screen_t* screen) {
+    return screen->width;
+}
+
+int hexes_screen_height(const hexes_screen_t* screen) {
+    return screen->height;
+}
+
+void hexes_screen_clear(hexes_screen_t* screen) {
+    fill_cells(screen->back, screen->width * screen->height);
+}
+
+void hexes_screen_put(hexes_screen_t* screen, int x, int y, char c, hexes_style_t style) {
+    if(x < 0 || y < 0 || x >= screen->width || y >= screen->height) return;
+    hexes_cell_t* cell = &screen->back[y * screen->width + x];
+    cell->glyph = c;
+    cell->style = style;
+}
+
+void hexes_screen_fill(hexes_screen_t* screen, int x, int y, int count, char c, hexes_style_t style) {
+    for(int i = 0; i < count; ++i) hexes_screen_put(screen, x + i, y, c, style);
+}
+
+int hexes_screen_print(hexes_screen_t* screen, int x, int y, const char* str, int length,
+                       hexes_style_t style) {
+    if(y < 0 || y >= screen->height || x >= screen->width) return 0;
+    if(x + length > screen->width) length = screen->width - x;
+    for(int i = 0; i < length; ++i) hexes_screen_put(screen, x + i, y, str[i], style);
+    return length < 0 ? 0 : length;
+}
+
+void hexes_screen_cursor(hexes_screen_t* screen, int x, int y) {
+    screen->cursorX = x;
+    screen->cursorY = y;
+}
+
+// MARK: - Scrolling
+
+void hexes_screen_scroll(hexes_screen_t* screen, int top, int bottom, int n) {
+    assert(screen && "cannot scroll a null screen");
+    if(top < 0) top = 0;
+    if(bottom > screen->height) bottom = screen->height;
+    int rows = bottom - top;
+    int amount = n > 0 ? n : -n;
+    // When nothing would be left of the region, redrawing it costs the same as scrolling it.
+    if(!n || amount >= rows || screen->invalid) return;
+
+    // Move what we believe is on the terminal the same way the terminal will, so the diff only
+    // finds the rows that scrolled in.
+    int width = screen->width;
+    hexes_cell_t* region = &screen->front[top * width];
+    int kept = (rows - amount) * width;
+    if(n > 0) {
+        memmove(region, region + amount * width, kept * sizeof(hexes_cell_t));
+        fill_cells(region + kept, amount * width);
+    } else {
+        memmove(region + amount * width, region, kept * sizeof(hexes_cell_t));
+        fill_cells(region, amount * width);
+    }
+
+    // Set the scrolling region (DECSTBM), scroll it up (SU) or down (SD), then reset the region.
+    char buffer[CSI_MAX_LENGTH];
+    int margins[] = {top + 1, bottom};
+    string_buf_append_n(&screen->scrolls, buffer, csi_sequence(buffer, margins, 2, 'r'));
+    char direction = n > 0 ? 'S' : 'T';
+    string_buf_append_n(&screen->scrolls, buffer, csi_sequence(buffer, &amount, 1, direction));
+    string_buf_append_n(&screen->scrolls, buffer, csi_sequence(buffer, NULL, 0, 'r'));
+}
+
+// MARK: - Diff rendering
+
+typedef struct {
+    int x, y;           // Where the terminal cursor is, or -1 if we don't know.
+    hexes_style_t style;
+    term_palette_t palette;
+} term_state_t;
+
+static term_style_t term_style(hexes_style_t style) {
+    return (term_style_t){
+        .fg = style.fg,
+        .bg = style.bg,
+        .bold = style.attrs & HEXES_ATTR_BOLD,
+        .underline = style.attrs & HEXES_ATTR_UNDERLINE,
+        .reverse = style.attrs & HEXES_ATTR_REVERSE,
+    };
+}
+
+// Cells are styled like everything else written to stdout, so bright colours and colours the
+// palette can't show come out the same way in both.
+static void emit_style(term_state_t* term, hexes_style_t style) {
+    if(same_style(term->style, style)) return;
+
+    char buffer[CSI_MAX_LENGTH];
+    term_style_t from = term_style(term->style);
+    int length = style_change(buffer, term->palette, &from, term_style(style));
+    if(length) hexes_write(buffer, length);
+    term->style = style;
+}
+
+static int digits(int n) {
+    int count = 1;
+    while(n >= 10) {
+        n /= 10;
+        count += 1;
+    }
+    return count;
+}
+
+static void emit_move(term_state_t* term, int x, int y) {
+    if(term->x == x && term->y == y) return;
+
+    // Absolute positioning always works, but relative moves are shorter when we're close.
+    int absolute = 4 + digits(y + 1) + digits(x + 1);
+    if(term->y == y && term->x >= 0) {
+        if(x == 0) {
+            hexes_putc('\r');
+        } else if(x > term->x && 3 + digits(x - term->x) < absolute) {
+            hexes_cursor_right(x - term->x);
+        } else if(x < term->x && 3 + digits(term->x - x) < absolute) {
+            hexes_cursor_left(term->x - x);
+        } else {
+            hexes_cursor_go(x, y);
+        }
+    } else if(x == 0 && term->y >= 0 && y > term->y && y - term->y + 1 < absolute) {
+        hexes_putc('\r');
+        for(int i = term->y; i < y; ++i) hexes_putc('\n');
+    } else {
+        hexes_cursor_go(x, y);
+    }
+    term->x = x;
+    term->y = y;
+}
+
+static void present_row(hexes_screen_t* screen, term_state_t* term, int y) {
+    hexes_cell_t* front = &screen->front[y * screen->width];
+    hexes_cell_t* back = &screen->back[y * screen->width];
+
+    int x = 0;
+    while(x < screen->width) {
+        if(same_cell(&front[x], &back[x])) {
+            x += 1;
+            continue;
+        }
+
+        // Find the end of the run, swallowing short stretches of unchanged cells.
+        int start = x;
+        int end = x + 1;
+        for(int i = end; i < screen->width && i - end <= SCREEN_MAX_GAP; ++i) {
+            if(!same_cell(&front[i], &back[i])) end = i + 1;
+        }
+
+        emit_move(term, start, y);
+        for(int i = start; i < end; ++i) {
+            emit_style(term, back[i].style);
+            hexes_putc(back[i].glyph ? back[i].glyph : ' ');
+            front[i] = back[i];
+        }
+
+        // Writing to the last column leaves the cursor in a terminal-dependent "pending wrap"
+        // state, so we stop assuming we know where it is.
+        term->x = end < screen->width ? end : -1;
+        if(term->x < 0) term->y = -1;
+        x = end;
+    }
+}
+
+void hexes_screen_present(hexes_screen_t* screen) {
+    assert(screen && "cannot present a null screen");
+    term_state_t term = {-1, -1, HEXES_STYLE_DEFAULT, term_palette(stdout)};
+
+    hexes_frame_begin();
+    char reset[CSI_MAX_LENGTH];
+    hexes_write(reset, csi_sgr(reset, NULL, 0));
+    if(screen->invalid) {
+        hexes_clear_screen();
+        fill_cells(screen->front, screen->width * screen->height);
+        screen->invalid = false;
+    }
+    // Scrolled rows are blanked with the current background, so this has to come after the reset.
+    hexes_write(screen->scrolls.data, screen->scrolls.count);
+    screen->scrolls.count = 0;
+
+    for(int y = 0; y < screen->height; ++y) present_row(screen, &term, y);
+
+    emit_style(&term, HEXES_STYLE_DEFAULT);
+    hexes_cursor_go(screen->cursorX, screen->cursorY);
+    hexes_frame_end();
+    term_style_invalidate(stdout);
+}
@@ -9,6 +9,8 @@
 //===--------------------------------------------------------------------------------------------===
 #ifndef term_shims_h
 #define term_shims_h
+#include <term/hexes.h>
+#include "csi.h"
 
 #ifdef _WIN32
 #include <conio.h>
@@ -45,63 +47,34 @@ static inline int getch(void) {
 // #define getch getchar
 #endif
 
+// The size comes from the hexes cache, which only asks the terminal again after a SIGWINCH.
 static inline int tcols(void) {
-#ifdef _WIN32
-	CONSOLE_SCREEN_BUFFER_INFO csbi;
-	if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi))
-		return -1;
-	else
-		return csbi.srWindow.Right - csbi.srWindow.Left + 1; // Window width
-		// return csbi.dwSize.X; // Buffer width
-#else
-#ifdef TIOCGSIZE
-	struct ttysize ts;
-	ioctl(STDIN_FILENO, TIOCGSIZE, &ts);
-	return ts.ts_cols;
-#elif defined(TIOCGWINSZ)
-	struct winsize ts;
-	ioctl(STDIN_FILENO, TIOCGWINSZ, &ts);
-	return ts.ws_col;
-#else // TIOCGSIZE
-	return -1;
-#endif // TIOCGSIZE
-#endif // _WIN32
+    int cols = 0;
+    return hexes_get_size(&cols, NULL) == 0 ? cols : -1;
 }
 
 static inline int trows(void) {
-#ifdef _WIN32
-	CONSOLE_SCREEN_BUFFER_INFO csbi;
-	if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi))
-		return -1;
-	else
-		return csbi.srWindow.Right - csbi.srWindow.Left + 1; // Window width
-		// return csbi.dwSize.X; // Buffer width
-#else
-#ifdef TIOCGSIZE
-	struct ttysize ts;
-	ioctl(STDIN_FILENO, TIOCGSIZE, &ts);
-	return ts.ts_lines;
-#elif defined(TIOCGWINSZ)
-	struct winsize ts;
-	ioctl(STDIN_FILENO, TIOCGWINSZ, &ts);
-	return ts.ws_row;
-#else // TIOCGSIZE
-	return -1;
-#endif // TIOCGSIZE
-#endif // _WIN32
+    int rows = 0;
+    return hexes_get_size(NULL, &rows) == 0 ? rows : -1;
 }
 
 
 // TODO: these should have win32 equivalents
-static inline void termUp(int n) { if(n) printf("\033[%dA", n); }
-static inline void termDown(int n) { if(n) printf("\033[%dB", n); }
-static inline void termRight(int n) { if(n) printf("\033[%dC", n); }
-static inline void termLeft(int n) { if(n) printf("\033[%dD", n); }
-static inline void termClear() { printf("\033[2J");}
+static inline void termMove(int n, char direction) {
+    if(n <= 0) return;
+    char buffer[CSI_MAX_LENGTH];
+    fwrite(buffer, 1, csi_cursor_move(buffer, n, direction), stdout);
+}
+
+static inline void termUp(int n) { termMove(n, 'A'); }
+static inline void termDown(int n) { termMove(n, 'B'); }
+static inline void termRight(int n) { termMove(n, 'C'); }
+static inline void termLeft(int n) { termMove(n, 'D'); }
+static inline void termClear() { fputs("\033[2J", stdout); }
 
-static inline void termClearLine() { printf("\033[2K"); }
+static inline void termClearLine() { fputs("\033[2K", stdout); }
 
-static inline void termAltStart() { printf("\033[?1049h"); fflush(stdout); }
-static inline void termAltStop() { printf("\033[?1049l"); fflush(stdout); }
+static inline void termAltStart() { fputs("\033[?1049h", stdout); fflush(stdout); }
+static inline void termAltStop() { fputs("\033[?1049l", stdout); fflush(stdout); }
 
 #endif
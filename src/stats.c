@@ -0,0 +1,73 @@
+//===--------------------------------------------------------------------------------------------===
+// stats.c - counters for what the library sends, reads and allocates
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#include <term/stats.h>
+#include "instrument.h"
+#include <string.h>
+
+term_escape_kind_t stats_escape_kind(char final) {
+    switch(final) {
+    case 'A': case 'B': case 'C': case 'D': case 'G': case 'H': case 'f':
+        return TERM_ESCAPE_CURSOR;
+    case 'J': case 'K':
+        return TERM_ESCAPE_ERASE;
+    case 'm':
+        return TERM_ESCAPE_SGR;
+    case 'S': case 'T': case 'r':
+        return TERM_ESCAPE_SCROLL;
+    case 'h': case 'l':
+        return TERM_ESCAPE_MODE;
+    default:
+        return TERM_ESCAPE_OTHER;
+    }
+}
+
+#ifdef TERMUTILS_STATS
+
+stats_counters_t statsCounters;
+
+#define LOAD(field) atomic_load_explicit(&statsCounters.field, memory_order_relaxed)
+#define CLEAR(field) atomic_store_explicit(&statsCounters.field, 0, memory_order_relaxed)
+
+bool term_stats_enabled() {
+    return true;
+}
+
+void term_stats(term_stats_t* stats) {
+    stats->bytes = LOAD(bytes);
+    stats->writes = LOAD(writes);
+    for(int i = 0; i < TERM_ESCAPE_KINDS; ++i) stats->escapes[i] = LOAD(escapes[i]);
+    stats->keys = LOAD(keys);
+    stats->reallocs = LOAD(reallocs);
+    stats->historyEntries = LOAD(historyEntries);
+    stats->historyBytes = LOAD(historyBytes);
+}
+
+void term_stats_reset() {
+    CLEAR(bytes);
+    CLEAR(writes);
+    for(int i = 0; i < TERM_ESCAPE_KINDS; ++i) CLEAR(escapes[i]);
+    CLEAR(keys);
+    CLEAR(reallocs);
+}
+
+#else
+
+bool term_stats_enabled() {
+    return false;
+}
+
+void term_stats(term_stats_t* stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+void term_stats_reset() {
+}
+
+#endif
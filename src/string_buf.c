@@ -8,6 +8,7 @@
 // =^•.•^=
 //===--------------------------------------------------------------------------------------------===
 #include "string_buf.h"
+#include "instrument.h"
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,6 +17,7 @@ void string_buf_ensure(string_buf_t* str, int count) {
     if(count < str->capacity) return;
     while(count >= str->capacity)
         str->capacity = str->capacity ? str->capacity * 2 : 32;
+    STATS_ADD(reallocs, 1);
     str->data = realloc(str->data, sizeof(char) * str->capacity);
 }
 
@@ -50,6 +52,15 @@ void string_buf_append(string_buf_t* str, char c) {
     string_buf_insert(str, str->count, c);
 }
 
+void string_buf_append_n(string_buf_t* str, const char* data, int count) {
+    assert(str && "cannot append to a null string");
+    assert(data && "cannot append a null char buffer");
+    string_buf_ensure(str, str->count + count);
+    memcpy(str->data + str->count, data, count);
+    str->count += count;
+    str->data[str->count] = '\0';
+}
+
 void string_buf_insert(string_buf_t* str, int pos, char c) {
     assert(str && "cannot insert a null string");
     string_buf_ensure(str, str->count + 1);
@@ -60,9 +71,19 @@ void string_buf_insert(string_buf_t* str, int pos, char c) {
     // str->count += 1;
 }
 
+void string_buf_insert_n(string_buf_t* str, int pos, const char* data, int count) {
+    assert(str && "cannot insert into a null string");
+    assert(data && "cannot insert a null char buffer");
+    string_buf_ensure(str, str->count + count);
+    memmove(str->data + pos + count, str->data + pos, str->count - pos);
+    memcpy(str->data + pos, data, count);
+    str->count += count;
+    str->data[str->count] = '\0';
+}
+
 void string_buf_erase(string_buf_t* str, int pos, int count) {
     assert(str && "cannot erase from a null string");
-    memmove(str->data + pos, str->data + pos + count, str->count - pos);
+    memmove(str->data + pos, str->data + pos + count, str->count - pos - count);
     str->count -= count;
     str->data[str->count] = '\0';
 }
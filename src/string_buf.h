@@ -17,6 +17,7 @@ typedef struct {
 } string_buf_t;
 
 void string_buf_init(string_buf_t* str);
+void string_buf_ensure(string_buf_t* str, int count);
 void string_buf_fini(string_buf_t* str);
 
 void string_buf_set(string_buf_t* str, const char* other);
@@ -25,7 +26,9 @@ void string_buf_set(string_buf_t* str, const char* other);
 // int stringCountColumns(const char* str, int length);
 
 void string_buf_append(string_buf_t* str, char c);
+void string_buf_append_n(string_buf_t* str, const char* data, int count);
 void string_buf_insert(string_buf_t* str, int pos, char c);
+void string_buf_insert_n(string_buf_t* str, int pos, const char* data, int count);
 void string_buf_erase(string_buf_t* str, int pos, int count);
 
 char* string_buf_take(string_buf_t* str);
@@ -0,0 +1,200 @@
+//===--------------------------------------------------------------------------------------------===
+// strip.c - removes escape sequences from text on its way to files and pipes
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#define _GNU_SOURCE
+#include <term/strip.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+enum {
+    STRIP_TEXT,
+    STRIP_ESCAPE,           // After ESC.
+    STRIP_INTERMEDIATE,     // After ESC and intermediate bytes, waiting for the final byte.
+    STRIP_CSI,              // In a control sequence, waiting for the final byte.
+    STRIP_STRING,           // In an OSC, DCS, SOS, PM or APC string.
+    STRIP_STRING_ESCAPE,    // After ESC in a string, which ends it if a backslash follows.
+};
+
+void term_strip_init(term_strip_t* strip) {
+    assert(strip && "cannot initialise a null filter");
+    strip->state = STRIP_TEXT;
+}
+
+int term_strip(term_strip_t* strip, const char* data, int length, char* out) {
+    assert(strip && "cannot strip with a null filter");
+    assert((data && out) || !length);
+    int state = strip->state;
+    int written = 0;
+    int i = 0;
+
+    while(i < length) {
+        if(state == STRIP_TEXT) {
+            // Text is copied in one go up to the next escape, which the C library's memchr finds
+            // a vector at a time.
+            const char* escape = memchr(data + i, 0x1b, length - i);
+            int end = escape ? (int)(escape - data) : length;
+            if(out + written != data + i) memmove(out + written, data + i, end - i);
+            written += end - i;
+            i = end;
+            if(!escape) break;
+            state = STRIP_ESCAPE;
+            i += 1;
+            continue;
+        }
+
+        uint8_t c = data[i++];
+        // Terminals act on control characters even in the middle of a sequence, so we keep them.
+        // ESC starts a new sequence instead.
+        if(c < 0x20 && state != STRIP_STRING && state != STRIP_STRING_ESCAPE) {
+            if(c == 0x1b) {
+                state = STRIP_ESCAPE;
+            } else {
+                out[written++] = c;
+                if(state == STRIP_ESCAPE) state = STRIP_TEXT;
+            }
+            continue;
+        }
+
+        switch(state) {
+        case STRIP_ESCAPE:
+            if(c == '[')
+                state = STRIP_CSI;
+            else if(c == ']' || c == 'P' || c == 'X' || c == '^' || c == '_')
+                state = STRIP_STRING;
+            else if(c < 0x30)
+                state = STRIP_INTERMEDIATE;
+            else
+                state = STRIP_TEXT;
+            break;
+
+        case STRIP_INTERMEDIATE:
+            if(c >= 0x30) state = STRIP_TEXT;
+            break;
+
+        case STRIP_CSI:
+            if(c >= 0x40 && c <= 0x7e) state = STRIP_TEXT;
+            break;
+
+        case STRIP_STRING:
+            // Strings end with BEL or ST (ESC \), and CAN and SUB cancel them.
+            if(c == '\a' || c == 0x18 || c == 0x1a)
+                state = STRIP_TEXT;
+            else if(c == 0x1b)
+                state = STRIP_STRING_ESCAPE;
+            break;
+
+        case STRIP_STRING_ESCAPE:
+            state = c == '\\' ? STRIP_TEXT : c == 0x1b ? STRIP_STRING_ESCAPE : STRIP_STRING;
+            break;
+        }
+    }
+    strip->state = state;
+    return written;
+}
+
+// MARK: - Streams
+
+#ifndef _WIN32
+
+// Filtered text is written out in chunks of this many bytes at most.
+#define STRIP_CHUNK 4096
+
+typedef struct {
+    term_strip_t strip;
+    FILE* sink;
+    int fd;
+} strip_stream_t;
+
+static bool write_out(strip_stream_t* stream, const char* data, int length) {
+    if(stream->sink) return fwrite(data, 1, length, stream->sink) == (size_t)length;
+    while(length > 0) {
+        ssize_t count = write(stream->fd, data, length);
+        if(count < 0) {
+            if(errno == EINTR) continue;
+            return false;
+        }
+        data += count;
+        length -= count;
+    }
+    return true;
+}
+
+static ssize_t stream_write(void* cookie, const char* data, size_t size) {
+    strip_stream_t* stream = cookie;
+    char buffer[STRIP_CHUNK];
+    for(size_t done = 0; done < size;) {
+        int length = size - done < STRIP_CHUNK ? (int)(size - done) : STRIP_CHUNK;
+        int kept = term_strip(&stream->strip, data + done, length, buffer);
+        if(kept && !write_out(stream, buffer, kept)) return -1;
+        done += length;
+    }
+    return size;
+}
+
+static int stream_close(void* cookie) {
+    strip_stream_t* stream = cookie;
+    int status = stream->sink ? fflush(stream->sink) : 0;
+    free(stream);
+    return status;
+}
+
+#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+static int funopen_write(void* cookie, const char* data, int size) {
+    return (int)stream_write(cookie, data, size);
+}
+#endif
+
+static FILE* open_stream(FILE* sink, int fd) {
+    strip_stream_t* stream = malloc(sizeof(strip_stream_t));
+    term_strip_init(&stream->strip);
+    stream->sink = sink;
+    stream->fd = fd;
+
+#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+    FILE* file = funopen(stream, NULL, funopen_write, NULL, stream_close);
+#else
+    cookie_io_functions_t functions = {.write = stream_write, .close = stream_close};
+    FILE* file = fopencookie(stream, "w", functions);
+#endif
+    if(!file) free(stream);
+    return file;
+}
+
+FILE* term_strip_open(FILE* sink) {
+    assert(sink && "cannot filter into a null stream");
+    return open_stream(sink, -1);
+}
+
+FILE* term_strip_fdopen(int fd) {
+    assert(fd >= 0 && "cannot filter into an invalid file descriptor");
+    return open_stream(NULL, fd);
+}
+
+#else
+
+FILE* term_strip_open(FILE* sink) {
+    (void)sink;
+    return NULL;
+}
+
+FILE* term_strip_fdopen(int fd) {
+    (void)fd;
+    return NULL;
+}
+
+#endif
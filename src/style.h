@@ -0,0 +1,28 @@
+//===--------------------------------------------------------------------------------------------===
+// style.h - style tracking shared between colours, screens and markup templates
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef term_style_h
+#define term_style_h
+#include <term/colors.h>
+
+/// Writes the sequence that takes a terminal using [palette] from style [from] to [to] into
+/// [buffer], which must have room for CSI_MAX_LENGTH bytes. Returns its length, which is 0 when
+/// both look the same. A null [from] means the style the terminal is in isn't known.
+int style_change(char* buffer, term_palette_t palette, const term_style_t* from, term_style_t to);
+/// Like style_change(), without counting the sequence in the stats, for templates that keep it.
+int style_encode(char* buffer, term_palette_t palette, const term_style_t* from, term_style_t to);
+/// Notes that something else put [term] in [style].
+void style_assume(FILE* term, term_style_t style);
+/// Returns whether [term] is known to be in the default style.
+bool style_is_default(FILE* term);
+/// Writes styled output to [term]. Output to stdout goes through hexes, so it joins the current
+/// frame if there is one, and reaches the current backend.
+void style_write(FILE* term, const char* data, int length);
+
+#endif
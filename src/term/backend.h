@@ -0,0 +1,49 @@
+//===--------------------------------------------------------------------------------------------===
+// backend.h - pluggable terminal I/O for hexes
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef term_backend_h
+#define term_backend_h
+#include <stdbool.h>
+
+typedef enum {
+    HEXES_MODE_NORMAL,      /// The terminal's own settings
+    HEXES_MODE_SESSION,     /// No echo, no line buffering (see hexes_session_begin())
+    HEXES_MODE_RAW,         /// Raw mode (see hexes_raw_start())
+} hexes_mode_t;
+
+/// Everything hexes, the line editor, the editor and the colour functions (when writing to stdout)
+/// send to or read from the terminal goes through the current backend. By default, that is the
+/// process's own terminal, on standard input and output.
+typedef struct {
+    void* context;      /// Passed back to every function
+
+    /// A file descriptor that becomes readable when there is input, for the event loop to poll, or
+    /// -1. Without one, the event loop checks for input every few milliseconds.
+    int inputFd;
+
+    /// Reads up to [size] bytes of input into [data], waiting up to [timeout] milliseconds for it
+    /// to arrive (or forever if [timeout] is negative). Returns the number of bytes read, 0 if
+    /// nothing came in time, or -1 at the end of input.
+    int (*read)(void* context, char* data, int size, int timeout);
+    /// Writes all of [data].
+    void (*write)(void* context, const char* data, int length);
+    /// Gets the terminal's size in cells. Returns 0 on success, or -1.
+    int (*size)(void* context, int* width, int* height);
+    /// Switches the terminal to [mode].
+    void (*mode)(void* context, hexes_mode_t mode);
+} hexes_backend_t;
+
+/// Makes hexes use [backend], which must stay valid until it is replaced. Passing NULL goes back to
+/// the process's terminal. Switch backends between input sessions, not during one.
+void hexes_set_backend(const hexes_backend_t* backend);
+const hexes_backend_t* hexes_get_backend();
+/// The backend for the process's own terminal.
+const hexes_backend_t* hexes_terminal_backend();
+
+#endif
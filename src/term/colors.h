@@ -31,10 +31,69 @@ typedef enum {
     TERM_BRIGHT_CYAN,
     TERM_BRIGHT_WHITE,
     TERM_INVALID_COLOR,
+
+    TERM_COLOR_INDEXED  = 1 << 24,  /// Flags colours made with TERM_INDEXED()
+    TERM_COLOR_RGB      = 1 << 25,  /// Flags colours made with TERM_RGB()
 } term_color_t;
 
+/// Entry [n] of the 256-colour palette.
+#define TERM_INDEXED(n) ((term_color_t)(TERM_COLOR_INDEXED | ((n) & 0xff)))
+/// A 24-bit colour.
+#define TERM_RGB(r, g, b) \
+    ((term_color_t)(TERM_COLOR_RGB | ((r) & 0xff) << 16 | ((g) & 0xff) << 8 | ((b) & 0xff)))
+
+/// How many colours a stream can show. Colours it can't show are sent as the closest one it can,
+/// looked up in tables built the first time they are needed.
+typedef enum {
+    TERM_PALETTE_16,
+    TERM_PALETTE_256,
+    TERM_PALETTE_RGB,
+} term_palette_t;
+
+/// A complete text style. Streams remember the last one set on them, so setting a style only sends
+/// what changed, merged into one sequence, and setting the current style again sends nothing.
+typedef struct {
+    term_color_t fg;
+    term_color_t bg;
+    bool bold;
+    bool underline;
+    bool reverse;
+} term_style_t;
+
+#define TERM_STYLE_DEFAULT ((term_style_t){TERM_DEFAULT, TERM_DEFAULT, false, false, false})
 
+/// Whether a stream gets colours and styles.
+typedef enum {
+    TERM_COLORS_AUTO,       /// Decided by the environment and whether the stream is a terminal
+    TERM_COLORS_NEVER,
+    TERM_COLORS_ALWAYS,
+} term_color_mode_t;
+
+/// Returns whether styles sent to [term] are shown. This is worked out the first time a stream is
+/// asked about, and remembered after that. NO_COLOR turns colours off, FORCE_COLOR turns them on
+/// (unless it is 0), and TERM=dumb turns them off. Otherwise, only terminals get colours.
 bool term_has_colors(FILE* term);
+/// Overrides what the environment says about [term]. Setting TERM_COLORS_AUTO checks it again,
+/// which is needed when a new stream reuses a closed one's FILE.
+void term_set_color_mode(FILE* term, term_color_mode_t mode);
+
+/// Returns the palette [term] uses: 24-bit when COLORTERM is truecolor or 24bit, 256 colours when
+/// TERM mentions 256color, and the 16 named colours otherwise.
+term_palette_t term_palette(FILE* term);
+/// Overrides the palette [term] uses.
+void term_set_palette(FILE* term, term_palette_t palette);
+/// Returns the colour closest to [color] that [palette] has.
+term_color_t term_color_downsample(term_color_t color, term_palette_t palette);
+
+/// Switches [term] to [style].
+void term_set_style(FILE* term, term_style_t style);
+/// Returns the style [term] is in, as far as we know.
+term_style_t term_get_style(FILE* term);
+/// Forgets what style [term] is in, for when something else wrote styles to it. The next style
+/// change is sent in full.
+void term_style_invalidate(FILE* term);
+
+
 void term_set_bold(FILE* term, bool bold);
 void term_set_underline(FILE* term, bool underline);
 
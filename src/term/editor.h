@@ -31,9 +31,18 @@ void termEditorDown();
 
 void termEditorReplace(const char* data);
 void termEditorClear();
+/// Draws the editor. When more input is already waiting, or the frame interval set with
+/// hexes_set_frame_interval() isn't up, the drawing is left to hexes_poll_event(), which does it
+/// once before it next waits.
 void termEditorRender();
 void termEditorInsert(char c);
+
+/// Waits for a key or a paste and applies it to the editor, redrawing when the terminal is resized
+/// while waiting. Returns the key, or -1 once standard input is closed.
 HexesKey termEditorUpdate();
+/// Applies a single event to the editor, for programs that run their own hexes_poll_event() loop.
+/// Returns the key for key and paste events, and -1 for anything else.
+HexesKey termEditorHandle(const hexes_event_t* event);
 
 
 #endif
@@ -10,6 +10,7 @@
 #ifndef term_hexes_h
 #define term_hexes_h
 #include <stdbool.h>
+#include <stdint.h>
 
 
 typedef enum {
@@ -34,14 +35,176 @@ typedef enum {
     KEY_END,
     KEY_PAGE_UP,
     KEY_PAGE_DOWN,
+    KEY_INSERT,
+    KEY_F1,
+    KEY_F2,
+    KEY_F3,
+    KEY_F4,
+    KEY_F5,
+    KEY_F6,
+    KEY_F7,
+    KEY_F8,
+    KEY_F9,
+    KEY_F10,
+    KEY_F11,
+    KEY_F12,
+    KEY_PASTE,
 } HexesKey;
 
+typedef enum {
+    HEXES_MOD_SHIFT     = 1 << 0,
+    HEXES_MOD_ALT       = 1 << 1,
+    HEXES_MOD_CTRL      = 1 << 2,
+} HexesMod;
+
+typedef enum {
+    HEXES_EVENT_KEY,
+    HEXES_EVENT_PASTE,
+    HEXES_EVENT_RESIZE,
+    HEXES_EVENT_TIMER,
+    HEXES_EVENT_FD,
+    HEXES_EVENT_MOUSE,
+} hexes_event_kind_t;
+
+typedef enum {
+    HEXES_MOUSE_PRESS,
+    HEXES_MOUSE_RELEASE,
+    HEXES_MOUSE_MOVE,
+    HEXES_MOUSE_WHEEL,
+} hexes_mouse_action_t;
+
+typedef enum {
+    HEXES_BUTTON_LEFT,
+    HEXES_BUTTON_MIDDLE,
+    HEXES_BUTTON_RIGHT,
+    HEXES_BUTTON_NONE,
+} hexes_button_t;
+
+typedef enum {
+    HEXES_MOUSE_OFF,
+    HEXES_MOUSE_CLICKS,     /// Presses, releases and the wheel
+    HEXES_MOUSE_DRAG,       /// Clicks, and moves while a button is held
+    HEXES_MOUSE_MOTION,     /// Clicks, and every move
+} hexes_mouse_mode_t;
+
+typedef enum {
+    HEXES_FD_READ       = 1 << 0,
+    HEXES_FD_WRITE      = 1 << 1,
+    HEXES_FD_ERROR      = 1 << 2,
+} hexes_fd_flags_t;
+
+typedef struct {
+    hexes_event_kind_t kind;
+    HexesKey key;   /// KEY_PASTE for paste events
+    int mods;       /// A combination of HexesMod flags
+
+    /// The pasted text, for paste events. It stays valid until the next call to an input function.
+    const char* text;
+    int length;
+
+    int64_t time;       /// When the input was read, for key and paste events (see hexes_clock())
+    int width, height;  /// The new terminal size, for resize events
+    int id;             /// The timer id for timer events, or the file descriptor for fd events
+    int ready;          /// A combination of hexes_fd_flags_t, for fd events
+    void* data;         /// The user data passed to hexes_watch_fd(), for fd events
+
+    hexes_mouse_action_t action;    /// What the mouse did, for mouse events
+    hexes_button_t button;          /// The button pressed, released, or held while moving
+    int x, y;                       /// The cell the mouse is over, from the top left corner
+    /// Wheel events: how many lines the wheel turned, positive downwards (dy) and to the right
+    /// (dx). Move events: how many cells the mouse moved since the previous one.
+    int dx, dy;
+} hexes_event_t;
+
 int hexes_get_char();
 int hexes_get_size(int* x, int* y);
 
 HexesKey hexes_get_key();
 HexesKey hexes_get_key_raw();
 
+// MARK: - Input events
+// Input is read from the terminal in bursts, one read() call at a time, and decoded into a queue of
+// events. A lone ESC is told apart from the start of an escape sequence with a short timeout.
+
+/// Blocks until an event is available. Returns false once standard input is closed.
+bool hexes_next_event(hexes_event_t* event);
+/// Copies up to [max] events into [events], blocking until there is at least one. Returns the
+/// number of events, or 0 once standard input is closed.
+int hexes_read_events(hexes_event_t* events, int max);
+/// Returns the number of events that can be read without blocking.
+int hexes_pending_events();
+
+// MARK: - Event loop
+// hexes_poll_event() waits for input, terminal resizes, timers and other file descriptors all at
+// once, so a program can handle its own I/O and the terminal from a single thread.
+
+/// Waits up to [timeout] milliseconds (forever if negative) for an event. Returns 1 if [event] was
+/// filled in, 0 if the timeout expired, and -1 once standard input is closed.
+int hexes_poll_event(hexes_event_t* event, int timeout);
+
+/// Schedules a timer event [interval] milliseconds from now, repeating if [repeat] is set. Returns
+/// the timer's id.
+int hexes_add_timer(int interval, bool repeat);
+void hexes_remove_timer(int id);
+
+/// Reports [fd] through hexes_poll_event() whenever it is ready for one of [flags] (HEXES_FD_READ,
+/// HEXES_FD_WRITE). Watching an fd that is already watched updates its flags and data.
+void hexes_watch_fd(int fd, int flags, void* data);
+void hexes_unwatch_fd(int fd);
+
+/// Asks for [render] to be called the next time hexes_poll_event() is about to wait, once the
+/// events already received are handled, and no sooner than hexes_frame_delay() allows. However many
+/// times it is scheduled in between, it only runs once. Scheduling a different function runs the
+/// one already scheduled first; passing NULL cancels it.
+void hexes_schedule_render(void (*render)(void*), void* data);
+/// Runs the scheduled render, if there is one, right away.
+void hexes_flush_render();
+
+/// Asks the terminal to mark pasted text, so it comes in as a single paste event (KEY_PASTE)
+/// instead of one key event per character.
+void hexes_set_bracketed_paste(bool enabled);
+/// Returns the text of the last paste returned by hexes_get_key() or hexes_get_key_raw().
+const char* hexes_get_paste(int* length);
+
+/// Asks the terminal to report the mouse, as SGR (mode 1006) mouse events. Moves and wheel turns
+/// that arrive faster than the program reads them are merged: a quick spin of the wheel comes in
+/// as one event, with the total in dy.
+void hexes_set_mouse(hexes_mouse_mode_t mode);
+
+// MARK: - Output
+// Everything hexes, the colour functions (when writing to stdout), the line editor and the editor
+// print goes through these. Between hexes_frame_begin() and hexes_frame_end(), output is gathered
+// in a single buffer and sent to the terminal with one write() when the outermost frame ends.
+// Outside of a frame, output goes straight to stdout through stdio.
+
+void hexes_frame_begin();
+void hexes_frame_end();
+bool hexes_frame_active();
+/// Sends what the current frame has gathered so far, however deeply nested it is, and sends output
+/// straight through until hexes_frame_resume(). Code that prints through stdio can run in between
+/// and stay in order. Returns the nesting depth to pass to hexes_frame_resume().
+int hexes_frame_suspend();
+/// Starts gathering output again, at the nesting depth hexes_frame_suspend() returned.
+void hexes_frame_resume(int depth);
+
+/// Sets the shortest time between two frames, in milliseconds (8 caps output at about 120 frames
+/// per second). The default, 0, leaves the frame rate up to the input rate.
+void hexes_set_frame_interval(int interval);
+/// Returns how many milliseconds are left before the frame interval allows another frame.
+int hexes_frame_delay();
+
+/// Whether frames are wrapped in synchronized output markers (DEC mode 2026), so the terminal
+/// shows each one at once. hexes_raw_start() checks hexes_caps() the first time it runs; terminals
+/// without the mode get plain frames.
+bool hexes_sync_supported();
+/// Forces synchronized output on or off, skipping detection.
+void hexes_set_sync(bool enabled);
+
+void hexes_write(const char* data, int length);
+void hexes_puts(const char* str);
+void hexes_putc(char c);
+int hexes_printf(const char* fmt, ...);
+
 void hexes_set_alternate(bool alt);
 
 void hexes_show_cursor(bool show);
@@ -54,9 +217,39 @@ void hexes_cursor_go(int x, int y);
 void hexes_clear_line();
 void hexes_clear_screen();
 
+// MARK: - Terminal modes
+
+/// Starts an input session: the terminal stops echoing input and buffering it by line until
+/// hexes_session_end() is called, or the program exits. hexes_get_char() and hexes_get_key() start
+/// one if needed, and leave it running so that reading input never reconfigures the terminal.
+void hexes_session_begin();
+void hexes_session_end();
+bool hexes_session_active();
+
+/// Puts the terminal in raw mode, on top of any running input session. The terminal's original
+/// settings are restored at exit, or if the program is killed by SIGINT, SIGTERM, SIGHUP or SIGQUIT.
 void hexes_raw_start();
 void hexes_raw_stop();
 
+// MARK: - Capabilities
+
+typedef struct {
+    bool truecolor;         /// COLORTERM says the terminal takes 24-bit colours
+    bool sync;              /// Synchronized output (DEC mode 2026)
+    bool bracketedPaste;    /// The terminal reported bracketed paste mode (DEC mode 2004)
+    bool kittyKeyboard;     /// The kitty keyboard protocol
+    char version[64];       /// The terminal's name and version (XTVERSION), or an empty string
+} hexes_caps_t;
+
+/// Returns what the terminal supports. The first call in a program either loads the results
+/// cached for this terminal (keyed by TERM, TERM_PROGRAM and TERM_PROGRAM_VERSION, under
+/// $XDG_CACHE_HOME/termutils, or ~/.cache/termutils) or queries the terminal, with all the queries
+/// sent at once and a short timeout. When standard input or output isn't a terminal, everything
+/// but truecolor is false.
+const hexes_caps_t* hexes_caps();
+/// Queries the terminal again, ignoring and then updating the cache.
+const hexes_caps_t* hexes_caps_probe();
+
 
 
 #endif
@@ -0,0 +1,45 @@
+//===--------------------------------------------------------------------------------------------===
+// latency.h - input-to-screen latency histograms
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef term_latency_h
+#define term_latency_h
+#include <stdint.h>
+#include <stdio.h>
+
+/// Every input event is stamped with the time its bytes were read (hexes_event_t.time). When the
+/// line editor or the editor sends a frame to the terminal, the time since the oldest input it
+/// hadn't shown yet goes into that source's histogram. Input handled in a batch counts from its
+/// first event, so coalesced renders are measured from the keystroke that waited longest.
+///
+/// Setting TERMUTILS_LATENCY in the environment prints the histograms when the program exits, to
+/// the file it names, or to stderr if it is set to "-".
+typedef enum {
+    HEXES_LATENCY_LINE,     /// line_get() and line_handle()
+    HEXES_LATENCY_EDITOR,   /// termEditorRender()
+    HEXES_LATENCY_SOURCES,
+} hexes_latency_source_t;
+
+/// Latencies are in milliseconds. Percentiles are within about 3% of the exact value.
+typedef struct {
+    long count;
+    double mean;
+    double p50;
+    double p99;
+    double max;
+} hexes_latency_t;
+
+/// Returns the current time on the clock event timestamps use, in microseconds.
+int64_t hexes_clock();
+
+hexes_latency_t hexes_latency(hexes_latency_source_t source);
+void hexes_latency_reset();
+/// Prints a line for each source that has samples.
+void hexes_latency_print(FILE* out);
+
+#endif
@@ -12,6 +12,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <term/colors.h>
+#include <term/hexes.h>
 
 #define CTL(c)      ((c) & 037)
 #define IS_CTL(c)   ((c) && (c) < ' ')
@@ -34,6 +35,10 @@ typedef struct line_cmd_s {
 
 /// Used to override defaults
 typedef struct line_functions_s {
+    /// Prints the prompt, through stdio or through hexes. On the terminal, the line editor sends
+    /// its pending output first, so the prompt lands in the right place either way. Other backends
+    /// only get what is written through hexes (hexes_puts(), hexes_printf(), or the colour
+    /// functions on stdout).
     void (*print_prompt)(const char*);
 } line_functions_t;
 
@@ -49,8 +54,19 @@ void line_run_cmd(line_action_t action, void* param);
 void line_set_prompt(line_t* line, const char* prompt);
 char* line_get(line_t* line);
 
+/// The pieces of line_get(), for programs that run their own hexes_poll_event() loop. Call
+/// line_start() to show the prompt, then pass each event to line_handle() until it returns
+/// LINE_RETURN (the line is in [result] and must be freed) or LINE_DONE (end of input). Pass a null
+/// [event] if standard input was closed. When more input is already waiting, edits are drawn all
+/// at once by hexes_poll_event(), before it next waits.
+void line_start(line_t* line);
+line_action_t line_handle(line_t* line, const hexes_event_t* event, char** result);
+
 void line_history_load(line_t* line, const char* path);
 void line_history_write(line_t* line, const char* path);
 void line_history_add(line_t* line, const char* entry);
+/// Returns the number of entries in [line]'s history and, if [bytes] isn't null, the memory they
+/// take up.
+int line_history_count(const line_t* line, size_t* bytes);
 
 #endif
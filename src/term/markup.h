@@ -0,0 +1,39 @@
+//===--------------------------------------------------------------------------------------------===
+// markup.h - styled output from precompiled markup templates
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef termutils_markup_h
+#define termutils_markup_h
+#include <stdarg.h>
+#include <stdio.h>
+
+/// A markup template is a printf format string with style tags in braces:
+///
+///     {bold} {underline} {reverse}    turn an attribute on
+///     {red} {bright_blue} {default}   set the foreground to a named colour
+///     {208} {#ff8000}                 set it to a 256-colour palette entry or a 24-bit colour
+///     {bg:red} {bg:208} {bg:#ff8000}  set the background
+///     {/}                             go back to the default style
+///     {{                              print a brace
+///
+/// Templates are compiled for one stream: their tags become the escape sequences that stream needs,
+/// merged when tags follow each other, and disappear when it doesn't get colours. Printing is then
+/// a single formatted write. Templates end in the default style.
+typedef struct term_markup_s term_markup_t;
+
+/// Compiles [markup] for [term]. Returns NULL if a tag isn't closed or isn't known.
+term_markup_t* term_markup_new(FILE* term, const char* markup);
+void term_markup_destroy(term_markup_t* markup);
+
+/// Prints [markup], formatting the arguments that follow as printf would. If the stream's colour
+/// support or palette changed since the template was compiled, it is compiled again first. Returns
+/// the number of bytes printed, or a negative value on a formatting error.
+int term_markup_print(term_markup_t* markup, ...);
+int term_markup_vprint(term_markup_t* markup, va_list args);
+
+#endif
@@ -9,6 +9,7 @@
 //===--------------------------------------------------------------------------------------------===
 #ifndef termutils_printing_h
 #define termutils_printing_h
+#include <stdbool.h>
 #include <stdio.h>
 
 typedef enum {TERM_INFO, TERM_WARN, TERM_ERROR} term_filter_t;
@@ -21,6 +22,31 @@ void term_error(const char* program, int code, const char* format, ...);
 void term_warn(const char* program, const char* format, ...);
 void term_info(const char* program, const char* format, ...);
 
+/// What happens to messages logged while the background writer is a whole queue behind.
+typedef enum {
+    TERM_LOG_BLOCK,     /// The logging thread waits for room.
+    TERM_LOG_DROP,      /// The message is dropped.
+    TERM_LOG_COUNT,     /// The message is dropped, and the writer says how many were once it can.
+} term_log_policy_t;
+
+/// Has messages from term_error(), term_warn() and term_info() written to stderr by a background
+/// thread, so that a slow terminal doesn't hold up the threads that log. Each message is formatted
+/// by the thread that logs it and written out whole, so messages from different threads don't
+/// get mixed up. Messages are written out in the order they were logged, but output written to
+/// stderr by other means can overtake them.
+///
+/// [full] says what to do when messages come faster than they can be written out. term_error()
+/// with an exit code always waits, and exits once every message is written out. Returns false if
+/// the writer is already running, or if the platform doesn't have threads.
+bool term_log_start(term_log_policy_t full);
+/// Returns once every message logged so far has been written out.
+void term_log_flush();
+/// Stops the background writer once every message is written out, and goes back to writing them
+/// from the thread that logs them. The writer is stopped at exit if it is still running then.
+void term_log_stop();
+/// Returns how many messages were dropped since the writer was started.
+unsigned long term_log_dropped();
+
 
 void term_print_usage(FILE* out, const char* program, const char** uses, int count);
 void term_print_contact(FILE* out, const char* program, const char* email, const char* website);
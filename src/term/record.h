@@ -0,0 +1,30 @@
+//===--------------------------------------------------------------------------------------------===
+// record.h - session recording, in asciicast format
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef term_record_h
+#define term_record_h
+#include <stdbool.h>
+
+/// Starts recording what hexes sends to the terminal into [path], as an asciicast (version 2) that
+/// asciinema or termutils-replay can play back. Resizes reported by the event loop are recorded as
+/// "r" events, since the output replays differently without them. If [input] is true, what is read
+/// from the terminal is recorded too, as "i" events.
+///
+/// Only output that goes through hexes is recorded: frames, hexes_write() and friends, and colours
+/// set on stdout. Frames are handed over to a background thread without being copied, and written
+/// out from there. The program only waits on the file when that thread falls a whole queue of
+/// entries behind, since dropping entries would leave a recording that doesn't replay to the same
+/// screen. Returns false if the file could not be created, or if a recording is already going.
+bool hexes_record_start(const char* path, bool input);
+/// Stops the recording, once everything recorded so far is written out. Recordings that are still
+/// going when the program exits are stopped then.
+void hexes_record_stop();
+bool hexes_recording();
+
+#endif
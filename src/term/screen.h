@@ -0,0 +1,75 @@
+//===--------------------------------------------------------------------------------------------===
+// screen.h - double-buffered cell grid for full-screen hexes programs
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef term_screen_h
+#define term_screen_h
+#include <stdbool.h>
+#include <stdint.h>
+#include <term/colors.h>
+
+typedef enum {
+    HEXES_ATTR_BOLD         = 1 << 0,
+    HEXES_ATTR_UNDERLINE    = 1 << 1,
+    HEXES_ATTR_REVERSE      = 1 << 2,
+} hexes_attr_t;
+
+/// Colours can be any term_color_t, 256-colour and 24-bit ones included. They are sent the way
+/// term_set_style() sends them, brought down to what stdout's palette can show.
+typedef struct {
+    term_color_t fg;
+    term_color_t bg;
+    uint8_t attrs;  /// A combination of hexes_attr_t flags
+} hexes_style_t;
+
+typedef struct {
+    char glyph;
+    hexes_style_t style;
+} hexes_cell_t;
+
+#define HEXES_STYLE(fg, bg, attrs) ((hexes_style_t){(fg), (bg), (attrs)})
+#define HEXES_STYLE_DEFAULT HEXES_STYLE(TERM_DEFAULT, TERM_DEFAULT, 0)
+
+/// A screen keeps two grids of cells: the front grid is what we believe is on the terminal, and
+/// the back grid is what the program drew since the last call to hexes_screen_present(). Presenting
+/// only sends the cells that differ between the two, with as few cursor movements as possible.
+typedef struct hexes_screen_s hexes_screen_t;
+
+hexes_screen_t* hexes_screen_new(int width, int height);
+void hexes_screen_destroy(hexes_screen_t* screen);
+
+/// Resizes both grids. The next present repaints the whole screen.
+void hexes_screen_resize(hexes_screen_t* screen, int width, int height);
+/// Forgets what is on the terminal, so the next present clears and repaints the whole screen.
+void hexes_screen_invalidate(hexes_screen_t* screen);
+
+int hexes_screen_width(const hexes_screen_t* screen);
+int hexes_screen_height(const hexes_screen_t* screen);
+
+/// Blanks the back grid.
+void hexes_screen_clear(hexes_screen_t* screen);
+void hexes_screen_put(hexes_screen_t* screen, int x, int y, char c, hexes_style_t style);
+void hexes_screen_fill(hexes_screen_t* screen, int x, int y, int count, char c, hexes_style_t style);
+/// Draws [length] bytes of [str] at (x, y), clipped to the right edge. Returns the number of cells
+/// that were drawn.
+int hexes_screen_print(hexes_screen_t* screen, int x, int y, const char* str, int length,
+                       hexes_style_t style);
+
+/// Scrolls rows [top, bottom) of the terminal by [n] lines: up when [n] is positive, so that new
+/// rows appear at the bottom, and down when it is negative. This happens on the terminal side when
+/// the screen is next presented, so only the rows that scrolled in need drawing. Scrolling the
+/// whole region away does nothing: the next present redraws it anyway.
+void hexes_screen_scroll(hexes_screen_t* screen, int top, int bottom, int n);
+
+/// Sets where the terminal cursor is left after presenting.
+void hexes_screen_cursor(hexes_screen_t* screen, int x, int y);
+
+/// Sends the difference between the back and front grids to the terminal, as a single frame.
+void hexes_screen_present(hexes_screen_t* screen);
+
+#endif
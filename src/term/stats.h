@@ -0,0 +1,47 @@
+//===--------------------------------------------------------------------------------------------===
+// stats.h - counters for what the library sends, reads and allocates
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef term_stats_h
+#define term_stats_h
+#include <stdbool.h>
+#include <stdint.h>
+
+/// The counters are only kept when the library is built with TERMUTILS_STATS (the CMake option of
+/// the same name). Without it, counting compiles to nothing and every counter stays at 0. With
+/// it, each count is a relaxed atomic add, so counters can be read from any thread.
+typedef enum {
+    TERM_ESCAPE_CURSOR,     /// Cursor movement and positioning
+    TERM_ESCAPE_ERASE,      /// Erasing lines and the screen
+    TERM_ESCAPE_SGR,        /// Styles and colours
+    TERM_ESCAPE_SCROLL,     /// Scrolling and scrolling regions
+    TERM_ESCAPE_MODE,       /// Terminal modes: cursor visibility, alternate screen, paste...
+    TERM_ESCAPE_OTHER,      /// Everything else, like queries
+    TERM_ESCAPE_KINDS,
+} term_escape_kind_t;
+
+typedef struct {
+    /// Bytes written by hexes (to stdout or the current backend) and by the colour functions.
+    uint64_t bytes;
+    /// write() and writev() calls made by hexes, or calls to a backend's write function. Output
+    /// hexes leaves to stdio, outside of frames, only counts towards [bytes].
+    uint64_t writes;
+    uint64_t escapes[TERM_ESCAPE_KINDS];    /// Control sequences emitted, by kind
+    uint64_t keys;                          /// Key events decoded from input
+    uint64_t reallocs;                      /// Times a dynamic string had to grow
+    uint64_t historyEntries;                /// Line editor history entries held right now
+    uint64_t historyBytes;                  /// Memory used by those entries
+} term_stats_t;
+
+bool term_stats_enabled();
+/// Copies the counters into [stats].
+void term_stats(term_stats_t* stats);
+/// Sets the counters back to 0, except for the history ones, which count what is held.
+void term_stats_reset();
+
+#endif
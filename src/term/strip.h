@@ -0,0 +1,33 @@
+//===--------------------------------------------------------------------------------------------===
+// strip.h - removes escape sequences from text on its way to files and pipes
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef termutils_strip_h
+#define termutils_strip_h
+#include <stdio.h>
+
+/// Where a filter is in the text it was given. Escape sequences can be split between two calls to
+/// term_strip(), so this is kept between them.
+typedef struct {
+    int state;
+} term_strip_t;
+
+void term_strip_init(term_strip_t* strip);
+
+/// Copies [length] bytes of [data] to [out], leaving out escape sequences (CSI, OSC and other
+/// strings, and two-byte ones). [out] needs room for [length] bytes, and can be [data] itself.
+/// Returns the number of bytes written to [out].
+int term_strip(term_strip_t* strip, const char* data, int length, char* out);
+
+/// Returns a stream that writes what it is given to [sink] without escape sequences, or NULL if
+/// the platform can't make custom streams. Closing it flushes [sink], but leaves it open.
+FILE* term_strip_open(FILE* sink);
+/// Like term_strip_open(), writing to the file descriptor [fd].
+FILE* term_strip_fdopen(int fd);
+
+#endif
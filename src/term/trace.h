@@ -0,0 +1,27 @@
+//===--------------------------------------------------------------------------------------------===
+// trace.h - timing spans for the library's main phases, as Chrome trace JSON
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef term_trace_h
+#define term_trace_h
+#include <stdbool.h>
+
+/// Libraries built with TERMUTILS_TRACE (the CMake option of the same name) time the main phases
+/// of input decoding, line editing, editing and rendering. Each thread keeps its spans in a buffer
+/// of its own, and they can be written out as a Chrome trace that Perfetto or chrome://tracing can
+/// open. Without the option, the hooks compile to nothing.
+///
+/// Setting TERMUTILS_TRACE in the environment writes the trace to the file it names when the
+/// program exits.
+bool term_trace_enabled();
+/// Writes the spans every thread has recorded so far to [path]. Threads that are still tracing
+/// while this runs may have their last few spans left out. Returns false if the file could not be
+/// written, or if tracing isn't built in.
+bool term_trace_write(const char* path);
+
+#endif
@@ -0,0 +1,64 @@
+//===--------------------------------------------------------------------------------------------===
+// vterm.h - headless in-memory terminal, usable as a hexes backend
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef term_vterm_h
+#define term_vterm_h
+#include <stdbool.h>
+#include <term/backend.h>
+#include <term/screen.h>
+
+/// A virtual terminal parses what is written to it into a grid of cells, the way a terminal
+/// emulator would, and keeps counts of what it took to get there. With hexes_vt_backend(), it lets
+/// programs using hexes run without a tty, and their output be measured and checked.
+///
+/// It understands the sequences TermUtils sends: cursor movement, erasing, SGR styles with basic,
+/// 256 and 24-bit colours, scrolling regions, the alternate screen, and the device attributes,
+/// mode and version queries. Every byte of printable text takes one cell.
+typedef struct hexes_vt_s hexes_vt_t;
+
+typedef struct {
+    long writes;        /// Calls to the backend's write function
+    long bytes;         /// Bytes written
+    long sequences;     /// Control sequences parsed
+    long cells;         /// Cells printed to
+    long changed;       /// Cells printed to whose glyph or style actually changed
+    long syncFrames;    /// Synchronized updates (DEC mode 2026) that were completed
+} hexes_vt_stats_t;
+
+hexes_vt_t* hexes_vt_new(int width, int height);
+void hexes_vt_destroy(hexes_vt_t* vt);
+
+/// Returns a backend that reads from and writes to [vt], for hexes_set_backend().
+const hexes_backend_t* hexes_vt_backend(hexes_vt_t* vt);
+
+/// Resizes the terminal. The event loop reports it as a resize event.
+void hexes_vt_resize(hexes_vt_t* vt, int width, int height);
+/// Queues [data] as if it had been typed, to be read by the program.
+void hexes_vt_input(hexes_vt_t* vt, const char* data, int length);
+/// Ends the program's input once what is queued has been read.
+void hexes_vt_close_input(hexes_vt_t* vt);
+/// Feeds [data] to the terminal, as if the program had written it.
+void hexes_vt_write(hexes_vt_t* vt, const char* data, int length);
+
+int hexes_vt_width(const hexes_vt_t* vt);
+int hexes_vt_height(const hexes_vt_t* vt);
+/// Returns the cell at (x, y). Outside of the grid, that is a blank cell.
+hexes_cell_t hexes_vt_cell(const hexes_vt_t* vt, int x, int y);
+/// Copies row [y] into [buffer] as a null-terminated string, without trailing blanks. [buffer]
+/// must have room for the terminal's width, plus one. Returns the string's length.
+int hexes_vt_row(const hexes_vt_t* vt, int y, char* buffer);
+void hexes_vt_cursor(const hexes_vt_t* vt, int* x, int* y);
+bool hexes_vt_cursor_visible(const hexes_vt_t* vt);
+bool hexes_vt_alternate(const hexes_vt_t* vt);
+hexes_mode_t hexes_vt_mode(const hexes_vt_t* vt);
+
+const hexes_vt_stats_t* hexes_vt_stats(const hexes_vt_t* vt);
+void hexes_vt_reset_stats(hexes_vt_t* vt);
+
+#endif
@@ -0,0 +1,23 @@
+//===--------------------------------------------------------------------------------------------===
+// width.h - how many terminal columns text takes up
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#ifndef termutils_width_h
+#define termutils_width_h
+
+/// Returns how many columns [codepoint] takes up: 2 for East Asian wide and fullwidth characters
+/// and most emoji, 0 for combining marks, zero-width characters and control characters, and 1
+/// for everything else.
+int term_codepoint_width(unsigned codepoint);
+
+/// Returns how many columns the first [length] bytes of [str] take up once printed. Escape
+/// sequences (CSI, OSC and two-byte ones) take up none, and text is read as UTF-8, with each byte
+/// that isn't part of a valid sequence taking one column, as terminals show it.
+int term_display_width(const char* str, int length);
+
+#endif
@@ -0,0 +1,171 @@
+//===--------------------------------------------------------------------------------------------===
+// trace.c - per-thread span buffers, written out as Chrome trace JSON
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#include <term/trace.h>
+#include "instrument.h"
+#include <stdio.h>
+
+#ifdef TERMUTILS_TRACE
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// Spans are kept in chunks that are never moved once allocated, so they can be read while their
+// thread keeps adding to them. A thread stops beginning spans once it fills TRACE_MAX_CHUNKS of
+// them (about 24MB), but still ends the ones it began, so none of them runs to the end of the trace.
+#define TRACE_CHUNK_SIZE    4096
+#define TRACE_MAX_CHUNKS    256
+
+typedef struct {
+    const char* name;
+    int64_t time;
+    char phase;
+} trace_event_t;
+
+typedef struct trace_chunk_s {
+    trace_event_t events[TRACE_CHUNK_SIZE];
+    atomic_int count;
+    struct trace_chunk_s* _Atomic next;
+} trace_chunk_t;
+
+typedef struct trace_thread_s {
+    int id;
+    int chunks;
+    bool stopped;   // We hit TRACE_MAX_CHUNKS, and only end the spans still open.
+    int depth;      // Spans we began and haven't ended yet.
+    int skipped;    // Spans begun since we stopped: their ends aren't recorded either.
+    trace_chunk_t* first;
+    trace_chunk_t* last;
+    struct trace_thread_s* next;
+} trace_thread_t;
+
+static _Atomic(trace_thread_t*) threads = NULL;
+static atomic_int nextThreadId = 1;
+static _Thread_local trace_thread_t* current = NULL;
+
+static atomic_bool checkedEnv = false;
+static const char* dumpPath = NULL;
+
+static void dump() {
+    term_trace_write(dumpPath);
+}
+
+static void check_env() {
+    if(atomic_exchange(&checkedEnv, true)) return;
+    dumpPath = getenv("TERMUTILS_TRACE");
+    if(dumpPath && *dumpPath) atexit(dump);
+}
+
+static trace_chunk_t* new_chunk() {
+    trace_chunk_t* chunk = malloc(sizeof(trace_chunk_t));
+    atomic_init(&chunk->count, 0);
+    atomic_init(&chunk->next, NULL);
+    return chunk;
+}
+
+static trace_thread_t* register_thread() {
+    check_env();
+    trace_thread_t* thread = malloc(sizeof(trace_thread_t));
+    thread->id = atomic_fetch_add(&nextThreadId, 1);
+    thread->chunks = 1;
+    thread->stopped = false;
+    thread->depth = 0;
+    thread->skipped = 0;
+    thread->first = thread->last = new_chunk();
+
+    thread->next = atomic_load(&threads);
+    while(!atomic_compare_exchange_weak(&threads, &thread->next, thread))
+        ;
+    return thread;
+}
+
+void trace_event(const char* name, char phase) {
+    if(!current) current = register_thread();
+    if(current->stopped) {
+        if(phase == 'B') current->skipped += 1;
+        if(phase != 'E') return;
+        if(current->skipped) {
+            current->skipped -= 1;
+            return;
+        }
+        if(!current->depth) return;
+    }
+
+    trace_chunk_t* chunk = current->last;
+    int count = atomic_load_explicit(&chunk->count, memory_order_relaxed);
+    if(count == TRACE_CHUNK_SIZE) {
+        // Ends get a chunk past the limit if they need one: there are only ever as many as there
+        // are spans open.
+        if(current->chunks >= TRACE_MAX_CHUNKS) {
+            current->stopped = true;
+            if(phase == 'B') current->skipped = 1;
+            if(phase != 'E') return;
+        }
+        trace_chunk_t* next = new_chunk();
+        atomic_store_explicit(&chunk->next, next, memory_order_release);
+        current->last = chunk = next;
+        current->chunks += 1;
+        count = 0;
+    }
+    chunk->events[count] = (trace_event_t){name, hexes_clock(), phase};
+    atomic_store_explicit(&chunk->count, count + 1, memory_order_release);
+    if(phase == 'B') current->depth += 1;
+    if(phase == 'E' && current->depth) current->depth -= 1;
+}
+
+bool term_trace_enabled() {
+    return true;
+}
+
+bool term_trace_write(const char* path) {
+    FILE* out = fopen(path, "w");
+    if(!out) return false;
+
+#ifdef _WIN32
+    int pid = 1;
+#else
+    int pid = getpid();
+#endif
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", out);
+    bool first = true;
+    for(trace_thread_t* thread = atomic_load(&threads); thread; thread = thread->next) {
+        trace_chunk_t* chunk = thread->first;
+        while(chunk) {
+            int count = atomic_load_explicit(&chunk->count, memory_order_acquire);
+            for(int i = 0; i < count; ++i) {
+                const trace_event_t* event = &chunk->events[i];
+                fprintf(out, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":%d,\"tid\":%d}",
+                        first ? "" : ",", event->name, event->phase, (long long)event->time,
+                        pid, thread->id);
+                first = false;
+            }
+            chunk = atomic_load_explicit(&chunk->next, memory_order_acquire);
+        }
+    }
+    fputs("\n]}\n", out);
+    return fclose(out) == 0;
+}
+
+#else
+
+bool term_trace_enabled() {
+    return false;
+}
+
+bool term_trace_write(const char* path) {
+    (void)path;
+    return false;
+}
+
+#endif
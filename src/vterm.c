@@ -0,0 +1,610 @@
+//===--------------------------------------------------------------------------------------------===
+// vterm.c - headless in-memory terminal, usable as a hexes backend
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#include <term/vterm.h>
+#include "csi.h"
+#include "string_buf.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VT_MAX_PARAMS 16
+
+typedef enum {
+    VT_GROUND,
+    VT_ESCAPE,
+    VT_CSI,
+    VT_STRING,          // OSC and DCS: we skip them until the string terminator.
+    VT_STRING_ESCAPE,
+} vt_state_t;
+
+struct hexes_vt_s {
+    int width;
+    int height;
+    hexes_cell_t* cells;
+    hexes_cell_t* mainCells;    // The main screen, while the alternate screen is up.
+
+    int x, y;
+    bool pendingWrap;           // We printed to the last column, and the next glyph goes below.
+    int savedX, savedY;
+    int top, bottom;            // The scrolling region, bottom excluded.
+    hexes_style_t style;
+
+    bool cursorVisible;
+    bool alternate;
+    bool bracketedPaste;
+    bool syncing;
+    hexes_mode_t mode;
+
+    vt_state_t state;
+    int params[VT_MAX_PARAMS];
+    int count;
+    bool inParam;
+    int prefix;
+    int intermediate;
+
+    string_buf_t input;
+    int inputHead;
+    bool inputClosed;
+
+    hexes_vt_stats_t stats;
+    hexes_backend_t backend;
+};
+
+static inline hexes_cell_t blank_cell(const hexes_vt_t* vt) {
+    // Erased cells take the current background colour, like they do in xterm.
+    return (hexes_cell_t){' ', {TERM_DEFAULT, vt->style.bg, 0}};
+}
+
+static inline int clamp(int value, int low, int high) {
+    return value < low ? low : value > high ? high : value;
+}
+
+static void fill_cells(hexes_cell_t* cells, int count, hexes_cell_t cell) {
+    for(int i = 0; i < count; ++i) cells[i] = cell;
+}
+
+// MARK: - Grid operations
+
+static void erase(hexes_vt_t* vt, int from, int to) {
+    fill_cells(&vt->cells[from], to - from, blank_cell(vt));
+}
+
+// Scrolls the scrolling region by [n] lines: up if [n] is positive, down if it is negative.
+static void scroll(hexes_vt_t* vt, int n) {
+    int rows = vt->bottom - vt->top;
+    int amount = clamp(n > 0 ? n : -n, 0, rows);
+    int width = vt->width;
+    hexes_cell_t* region = &vt->cells[vt->top * width];
+    int kept = (rows - amount) * width;
+
+    if(n > 0) {
+        memmove(region, region + amount * width, kept * sizeof(hexes_cell_t));
+        fill_cells(region + kept, amount * width, blank_cell(vt));
+    } else {
+        memmove(region + amount * width, region, kept * sizeof(hexes_cell_t));
+        fill_cells(region, amount * width, blank_cell(vt));
+    }
+}
+
+static void line_feed(hexes_vt_t* vt) {
+    vt->pendingWrap = false;
+    if(vt->y == vt->bottom - 1)
+        scroll(vt, 1);
+    else if(vt->y < vt->height - 1)
+        vt->y += 1;
+}
+
+static void reverse_index(hexes_vt_t* vt) {
+    vt->pendingWrap = false;
+    if(vt->y == vt->top)
+        scroll(vt, -1);
+    else if(vt->y > 0)
+        vt->y -= 1;
+}
+
+static void move_to(hexes_vt_t* vt, int x, int y) {
+    vt->x = clamp(x, 0, vt->width - 1);
+    vt->y = clamp(y, 0, vt->height - 1);
+    vt->pendingWrap = false;
+}
+
+static void print(hexes_vt_t* vt, char glyph) {
+    if(!vt->width || !vt->height) return;
+    if(vt->pendingWrap) {
+        vt->x = 0;
+        line_feed(vt);
+    }
+
+    hexes_cell_t* cell = &vt->cells[vt->y * vt->width + vt->x];
+    hexes_cell_t printed = {glyph, vt->style};
+    vt->stats.cells += 1;
+    if(cell->glyph != printed.glyph || cell->style.fg != printed.style.fg
+       || cell->style.bg != printed.style.bg || cell->style.attrs != printed.style.attrs)
+        vt->stats.changed += 1;
+    *cell = printed;
+
+    if(vt->x == vt->width - 1)
+        vt->pendingWrap = true;
+    else
+        vt->x += 1;
+}
+
+static void set_alternate(hexes_vt_t* vt, bool alternate) {
+    if(alternate == vt->alternate) return;
+    int count = vt->width * vt->height;
+    if(alternate) {
+        vt->savedX = vt->x;
+        vt->savedY = vt->y;
+        vt->mainCells = malloc(count * sizeof(hexes_cell_t));
+        memcpy(vt->mainCells, vt->cells, count * sizeof(hexes_cell_t));
+        erase(vt, 0, count);
+    } else {
+        memcpy(vt->cells, vt->mainCells, count * sizeof(hexes_cell_t));
+        free(vt->mainCells);
+        vt->mainCells = NULL;
+        move_to(vt, vt->savedX, vt->savedY);
+    }
+    vt->alternate = alternate;
+}
+
+// MARK: - Replies
+
+static void reply(hexes_vt_t* vt, const char* data, int length) {
+    string_buf_append_n(&vt->input, data, length);
+}
+
+static void reply_mode(hexes_vt_t* vt, int mode) {
+    // DECRPM: 1 is set, 2 is reset, 0 is a mode we don't know.
+    int state = 0;
+    switch(mode) {
+    case 25: state = vt->cursorVisible ? 1 : 2; break;
+    case 1049: state = vt->alternate ? 1 : 2; break;
+    case 2004: state = vt->bracketedPaste ? 1 : 2; break;
+    case 2026: state = vt->syncing ? 1 : 2; break;
+    default: break;
+    }
+    char buffer[CSI_MAX_LENGTH];
+    int length = snprintf(buffer, sizeof(buffer), "\033[?%d;%d$y", mode, state);
+    reply(vt, buffer, length);
+}
+
+// MARK: - Control sequences
+
+static inline int param(const hexes_vt_t* vt, int i, int fallback) {
+    return i < vt->count && vt->params[i] > 0 ? vt->params[i] : fallback;
+}
+
+static void set_private_mode(hexes_vt_t* vt, int mode, bool enabled) {
+    switch(mode) {
+    case 25: vt->cursorVisible = enabled; break;
+    case 1049: set_alternate(vt, enabled); break;
+    case 2004: vt->bracketedPaste = enabled; break;
+    case 2026:
+        if(vt->syncing && !enabled) vt->stats.syncFrames += 1;
+        vt->syncing = enabled;
+        break;
+    default: break;
+    }
+}
+
+static void sgr(hexes_vt_t* vt) {
+    if(!vt->count) {
+        vt->style = HEXES_STYLE_DEFAULT;
+        return;
+    }
+    for(int i = 0; i < vt->count; ++i) {
+        int code = vt->params[i] < 0 ? 0 : vt->params[i];
+        if(code == 0) vt->style = HEXES_STYLE_DEFAULT;
+        else if(code == 1) vt->style.attrs |= HEXES_ATTR_BOLD;
+        else if(code == 4) vt->style.attrs |= HEXES_ATTR_UNDERLINE;
+        else if(code == 7) vt->style.attrs |= HEXES_ATTR_REVERSE;
+        else if(code == 22) vt->style.attrs &= ~HEXES_ATTR_BOLD;
+        else if(code == 24) vt->style.attrs &= ~HEXES_ATTR_UNDERLINE;
+        else if(code == 27) vt->style.attrs &= ~HEXES_ATTR_REVERSE;
+        else if(code >= 30 && code <= 37) vt->style.fg = TERM_BLACK + code - 30;
+        else if(code == 39) vt->style.fg = TERM_DEFAULT;
+        else if(code >= 40 && code <= 47) vt->style.bg = TERM_BLACK + code - 40;
+        else if(code == 49) vt->style.bg = TERM_DEFAULT;
+        else if(code >= 90 && code <= 97) vt->style.fg = TERM_BRIGHT_BLACK + code - 90;
+        else if(code >= 100 && code <= 107) vt->style.bg = TERM_BRIGHT_BLACK + code - 100;
+        else if(code == 38 || code == 48) {
+            term_color_t* color = code == 38 ? &vt->style.fg : &vt->style.bg;
+            int kind = i + 1 < vt->count ? vt->params[i + 1] : 0;
+            int used = kind == 5 ? 2 : kind == 2 ? 4 : 1;
+            if(i + used >= vt->count) break;
+            const int* p = &vt->params[i + 2];
+            if(kind == 5) *color = TERM_INDEXED(p[0]);
+            if(kind == 2) *color = TERM_RGB(p[0], p[1], p[2]);
+            i += used;
+        }
+    }
+}
+
+static void dispatch_csi(hexes_vt_t* vt, int final) {
+    vt->stats.sequences += 1;
+
+    if(vt->prefix == '?') {
+        if(final == 'h' || final == 'l') {
+            for(int i = 0; i < vt->count; ++i) set_private_mode(vt, vt->params[i], final == 'h');
+        } else if(final == 'p' && vt->intermediate == '$') {
+            reply_mode(vt, param(vt, 0, 0));
+        }
+        return;
+    }
+    if(vt->prefix == '>') {
+        if(final == 'q') {
+            static const char version[] = "\033P>|termutils-vt\033\\";
+            reply(vt, version, sizeof(version) - 1);
+        }
+        return;
+    }
+    if(vt->prefix || vt->intermediate) return;
+
+    int n = param(vt, 0, 1);
+    int last = vt->width * vt->height;
+    int here = vt->y * vt->width + vt->x;
+    switch(final) {
+    case 'A': move_to(vt, vt->x, vt->y - n); break;
+    case 'B': move_to(vt, vt->x, vt->y + n); break;
+    case 'C': move_to(vt, vt->x + n, vt->y); break;
+    case 'D': move_to(vt, vt->x - n, vt->y); break;
+    case 'E': move_to(vt, 0, vt->y + n); break;
+    case 'F': move_to(vt, 0, vt->y - n); break;
+    case 'G': move_to(vt, n - 1, vt->y); break;
+    case 'd': move_to(vt, vt->x, n - 1); break;
+    case 'H':
+    case 'f':
+        move_to(vt, param(vt, 1, 1) - 1, n - 1);
+        break;
+
+    case 'J':
+        switch(param(vt, 0, 0)) {
+        case 0: erase(vt, here, last); break;
+        case 1: erase(vt, 0, here + 1); break;
+        default: erase(vt, 0, last); break;
+        }
+        break;
+
+    case 'K': {
+        int start = vt->y * vt->width;
+        switch(param(vt, 0, 0)) {
+        case 0: erase(vt, here, start + vt->width); break;
+        case 1: erase(vt, start, here + 1); break;
+        default: erase(vt, start, start + vt->width); break;
+        }
+        break;
+    }
+
+    case 'X': erase(vt, here, here + clamp(n, 0, vt->width - vt->x)); break;
+    case 'S': scroll(vt, n); break;
+    case 'T': scroll(vt, -n); break;
+    case 'm': sgr(vt); break;
+
+    case 'r': {
+        int top = param(vt, 0, 1) - 1;
+        int bottom = param(vt, 1, vt->height);
+        if(bottom > vt->height) bottom = vt->height;
+        if(top >= bottom - 1) break;
+        vt->top = top;
+        vt->bottom = bottom;
+        move_to(vt, 0, 0);
+        break;
+    }
+
+    case 's':
+        vt->savedX = vt->x;
+        vt->savedY = vt->y;
+        break;
+    case 'u': move_to(vt, vt->savedX, vt->savedY); break;
+
+    case 'c': {
+        static const char attributes[] = "\033[?62;22c";
+        reply(vt, attributes, sizeof(attributes) - 1);
+        break;
+    }
+    case 'n':
+        if(param(vt, 0, 0) == 6) {
+            char buffer[CSI_MAX_LENGTH];
+            int length = snprintf(buffer, sizeof(buffer), "\033[%d;%dR", vt->y + 1, vt->x + 1);
+            reply(vt, buffer, length);
+        }
+        break;
+    default: break;
+    }
+}
+
+static void dispatch_escape(hexes_vt_t* vt, int c) {
+    vt->stats.sequences += 1;
+    if(vt->intermediate) return; // Character sets and the like.
+    switch(c) {
+    case '7':
+        vt->savedX = vt->x;
+        vt->savedY = vt->y;
+        break;
+    case '8': move_to(vt, vt->savedX, vt->savedY); break;
+    case 'D': line_feed(vt); break;
+    case 'E':
+        vt->x = 0;
+        line_feed(vt);
+        break;
+    case 'M': reverse_index(vt); break;
+    default: break;
+    }
+}
+
+// MARK: - Parser
+
+static void start_sequence(hexes_vt_t* vt, vt_state_t state) {
+    vt->state = state;
+    vt->count = 0;
+    vt->inParam = false;
+    vt->prefix = 0;
+    vt->intermediate = 0;
+}
+
+static void parse_csi(hexes_vt_t* vt, int c) {
+    if(c >= '0' && c <= '9') {
+        if(!vt->inParam && vt->count < VT_MAX_PARAMS) {
+            vt->params[vt->count++] = 0;
+            vt->inParam = true;
+        }
+        int* value = &vt->params[vt->count - 1];
+        if(vt->inParam && *value < 100000) *value = *value * 10 + (c - '0');
+    } else if(c == ';' || c == ':') {
+        if(!vt->inParam && vt->count < VT_MAX_PARAMS) vt->params[vt->count++] = -1;
+        vt->inParam = false;
+    } else if(c >= '<' && c <= '?') {
+        if(!vt->count && !vt->prefix) vt->prefix = c;
+    } else if(c >= 0x20 && c <= 0x2f) {
+        vt->intermediate = c;
+    } else if(c >= 0x40 && c <= 0x7e) {
+        vt->state = VT_GROUND;
+        dispatch_csi(vt, c);
+    } else if(c == 0x1b) {
+        start_sequence(vt, VT_ESCAPE);
+    } else if(c >= 0x20) {
+        vt->state = VT_GROUND;
+    }
+}
+
+static void parse_escape(hexes_vt_t* vt, int c) {
+    switch(c) {
+    case '[': start_sequence(vt, VT_CSI); break;
+    case ']':
+    case 'P':
+    case '_':
+    case '^':
+        vt->state = VT_STRING;
+        break;
+    default:
+        if(c >= 0x20 && c <= 0x2f) {
+            vt->intermediate = c;
+            break;
+        }
+        vt->state = VT_GROUND;
+        dispatch_escape(vt, c);
+        break;
+    }
+}
+
+static void parse_ground(hexes_vt_t* vt, int c) {
+    switch(c) {
+    case 0x1b: start_sequence(vt, VT_ESCAPE); break;
+    case '\r':
+        vt->x = 0;
+        vt->pendingWrap = false;
+        break;
+    case '\n':
+    case '\v':
+    case '\f':
+        line_feed(vt);
+        break;
+    case '\b':
+        if(vt->x > 0) vt->x -= 1;
+        vt->pendingWrap = false;
+        break;
+    case '\t':
+        move_to(vt, (vt->x / 8 + 1) * 8, vt->y);
+        break;
+    default:
+        if(c >= 0x20 && c != 0x7f) print(vt, c);
+        break;
+    }
+}
+
+void hexes_vt_write(hexes_vt_t* vt, const char* data, int length) {
+    assert(vt && "cannot write to a null virtual terminal");
+    for(int i = 0; i < length; ++i) {
+        int c = (unsigned char)data[i];
+        switch(vt->state) {
+        case VT_GROUND: parse_ground(vt, c); break;
+        case VT_ESCAPE: parse_escape(vt, c); break;
+        case VT_CSI: parse_csi(vt, c); break;
+        case VT_STRING:
+            if(c == 0x07) {
+                vt->state = VT_GROUND;
+                vt->stats.sequences += 1;
+            } else if(c == 0x1b) {
+                vt->state = VT_STRING_ESCAPE;
+            }
+            break;
+        case VT_STRING_ESCAPE:
+            vt->state = c == '\\' ? VT_GROUND : VT_STRING;
+            if(vt->state == VT_GROUND) vt->stats.sequences += 1;
+            break;
+        }
+    }
+}
+
+// MARK: - Backend
+
+static int vt_read(void* context, char* data, int size, int timeout) {
+    // Input only comes from hexes_vt_input(), so there is never anything worth waiting for.
+    (void)timeout;
+    hexes_vt_t* vt = context;
+    int available = vt->input.count - vt->inputHead;
+    if(!available) return vt->inputClosed ? -1 : 0;
+
+    int length = available < size ? available : size;
+    memcpy(data, vt->input.data + vt->inputHead, length);
+    vt->inputHead += length;
+    if(vt->inputHead == vt->input.count) {
+        vt->input.count = 0;
+        vt->inputHead = 0;
+    }
+    return length;
+}
+
+static void vt_write(void* context, const char* data, int length) {
+    hexes_vt_t* vt = context;
+    vt->stats.writes += 1;
+    vt->stats.bytes += length;
+    hexes_vt_write(vt, data, length);
+}
+
+static int vt_size(void* context, int* width, int* height) {
+    hexes_vt_t* vt = context;
+    *width = vt->width;
+    *height = vt->height;
+    return 0;
+}
+
+static void vt_mode(void* context, hexes_mode_t mode) {
+    hexes_vt_t* vt = context;
+    vt->mode = mode;
+}
+
+// MARK: - Public API
+
+hexes_vt_t* hexes_vt_new(int width, int height) {
+    hexes_vt_t* vt = calloc(1, sizeof(hexes_vt_t));
+    assert(vt && "virtual terminal allocation failed");
+    vt->style = HEXES_STYLE_DEFAULT;
+    vt->cursorVisible = true;
+    vt->mode = HEXES_MODE_NORMAL;
+    vt->state = VT_GROUND;
+    string_buf_init(&vt->input);
+
+    vt->backend = (hexes_backend_t){
+        .context = vt,
+        .inputFd = -1,
+        .read = vt_read,
+        .write = vt_write,
+        .size = vt_size,
+        .mode = vt_mode,
+    };
+    hexes_vt_resize(vt, width, height);
+    return vt;
+}
+
+void hexes_vt_destroy(hexes_vt_t* vt) {
+    assert(vt && "cannot destroy a null virtual terminal");
+    free(vt->cells);
+    free(vt->mainCells);
+    string_buf_fini(&vt->input);
+    free(vt);
+}
+
+const hexes_backend_t* hexes_vt_backend(hexes_vt_t* vt) {
+    assert(vt && "cannot get the backend of a null virtual terminal");
+    return &vt->backend;
+}
+
+// Keeps what fits of [cells] in a grid of the new size.
+static hexes_cell_t* resize_cells(const hexes_vt_t* vt, hexes_cell_t* cells, int width, int height) {
+    hexes_cell_t* resized = malloc(width * height * sizeof(hexes_cell_t));
+    fill_cells(resized, width * height, (hexes_cell_t){' ', HEXES_STYLE_DEFAULT});
+    for(int y = 0; cells && y < height && y < vt->height; ++y) {
+        int count = width < vt->width ? width : vt->width;
+        memcpy(&resized[y * width], &cells[y * vt->width], count * sizeof(hexes_cell_t));
+    }
+    free(cells);
+    return resized;
+}
+
+void hexes_vt_resize(hexes_vt_t* vt, int width, int height) {
+    assert(vt && "cannot resize a null virtual terminal");
+    if(width < 0) width = 0;
+    if(height < 0) height = 0;
+    vt->cells = resize_cells(vt, vt->cells, width, height);
+    if(vt->mainCells) vt->mainCells = resize_cells(vt, vt->mainCells, width, height);
+
+    vt->width = width;
+    vt->height = height;
+    vt->top = 0;
+    vt->bottom = height;
+    vt->savedX = clamp(vt->savedX, 0, width ? width - 1 : 0);
+    vt->savedY = clamp(vt->savedY, 0, height ? height - 1 : 0);
+    vt->x = clamp(vt->x, 0, width ? width - 1 : 0);
+    vt->y = clamp(vt->y, 0, height ? height - 1 : 0);
+    vt->pendingWrap = false;
+}
+
+void hexes_vt_input(hexes_vt_t* vt, const char* data, int length) {
+    assert(vt && "cannot send input to a null virtual terminal");
+    string_buf_append_n(&vt->input, data, length);
+}
+
+void hexes_vt_close_input(hexes_vt_t* vt) {
+    assert(vt && "cannot close the input of a null virtual terminal");
+    vt->inputClosed = true;
+}
+
+int hexes_vt_width(const hexes_vt_t* vt) {
+    return vt->width;
+}
+
+int hexes_vt_height(const hexes_vt_t* vt) {
+    return vt->height;
+}
+
+hexes_cell_t hexes_vt_cell(const hexes_vt_t* vt, int x, int y) {
+    if(x < 0 || y < 0 || x >= vt->width || y >= vt->height)
+        return (hexes_cell_t){' ', HEXES_STYLE_DEFAULT};
+    return vt->cells[y * vt->width + x];
+}
+
+int hexes_vt_row(const hexes_vt_t* vt, int y, char* buffer) {
+    assert(buffer && "cannot copy a row into a null buffer");
+    int length = 0;
+    for(int x = 0; y >= 0 && y < vt->height && x < vt->width; ++x) {
+        char glyph = vt->cells[y * vt->width + x].glyph;
+        buffer[x] = glyph;
+        if(glyph != ' ') length = x + 1;
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+void hexes_vt_cursor(const hexes_vt_t* vt, int* x, int* y) {
+    if(x) *x = vt->x;
+    if(y) *y = vt->y;
+}
+
+bool hexes_vt_cursor_visible(const hexes_vt_t* vt) {
+    return vt->cursorVisible;
+}
+
+bool hexes_vt_alternate(const hexes_vt_t* vt) {
+    return vt->alternate;
+}
+
+hexes_mode_t hexes_vt_mode(const hexes_vt_t* vt) {
+    return vt->mode;
+}
+
+const hexes_vt_stats_t* hexes_vt_stats(const hexes_vt_t* vt) {
+    return &vt->stats;
+}
+
+void hexes_vt_reset_stats(hexes_vt_t* vt) {
+    memset(&vt->stats, 0, sizeof(vt->stats));
+}
@@ -0,0 +1,213 @@
+//===--------------------------------------------------------------------------------------------===
+// width.c - how many terminal columns text takes up
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#include <term/width.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+#define WIDTH_SSE2
+#endif
+
+typedef struct {
+    unsigned first;
+    unsigned last;
+} range_t;
+
+// Combining marks and other characters that don't move the cursor.
+static const range_t zeroWidth[] = {
+    {0x0300, 0x036f}, {0x0483, 0x0489}, {0x0591, 0x05bd}, {0x05bf, 0x05bf}, {0x05c1, 0x05c2},
+    {0x05c4, 0x05c5}, {0x05c7, 0x05c7}, {0x0610, 0x061a}, {0x064b, 0x065f}, {0x0670, 0x0670},
+    {0x06d6, 0x06dc}, {0x06df, 0x06e4}, {0x06e7, 0x06e8}, {0x06ea, 0x06ed}, {0x0711, 0x0711},
+    {0x0730, 0x074a}, {0x07a6, 0x07b0}, {0x0900, 0x0902}, {0x093a, 0x093a}, {0x093c, 0x093c},
+    {0x0941, 0x0948}, {0x094d, 0x094d}, {0x0951, 0x0957}, {0x0962, 0x0963}, {0x0981, 0x0981},
+    {0x09bc, 0x09bc}, {0x09c1, 0x09c4}, {0x09cd, 0x09cd}, {0x0e31, 0x0e31}, {0x0e34, 0x0e3a},
+    {0x0e47, 0x0e4e}, {0x0eb1, 0x0eb1}, {0x0eb4, 0x0ebc}, {0x0ec8, 0x0ecd}, {0x1160, 0x11ff},
+    {0x1ab0, 0x1aff}, {0x1dc0, 0x1dff}, {0x200b, 0x200f}, {0x202a, 0x202e}, {0x2060, 0x2064},
+    {0x20d0, 0x20ff}, {0x302a, 0x302d}, {0x3099, 0x309a}, {0xfe00, 0xfe0f}, {0xfe20, 0xfe2f},
+    {0xfeff, 0xfeff}, {0x1f3fb, 0x1f3ff}, {0xe0001, 0xe0001}, {0xe0020, 0xe007f},
+    {0xe0100, 0xe01ef},
+};
+
+// East Asian wide and fullwidth characters, and emoji that are shown wide by default.
+static const range_t doubleWidth[] = {
+    {0x1100, 0x115f}, {0x231a, 0x231b}, {0x2329, 0x232a}, {0x23e9, 0x23ec}, {0x23f0, 0x23f0},
+    {0x23f3, 0x23f3}, {0x25fd, 0x25fe}, {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267f, 0x267f},
+    {0x2693, 0x2693}, {0x26a1, 0x26a1}, {0x26aa, 0x26ab}, {0x26bd, 0x26be}, {0x26c4, 0x26c5},
+    {0x26ce, 0x26ce}, {0x26d4, 0x26d4}, {0x26ea, 0x26ea}, {0x26f2, 0x26f3}, {0x26f5, 0x26f5},
+    {0x26fa, 0x26fa}, {0x26fd, 0x26fd}, {0x2705, 0x2705}, {0x270a, 0x270b}, {0x2728, 0x2728},
+    {0x274c, 0x274c}, {0x274e, 0x274e}, {0x2753, 0x2755}, {0x2757, 0x2757}, {0x2795, 0x2797},
+    {0x27b0, 0x27b0}, {0x27bf, 0x27bf}, {0x2b1b, 0x2b1c}, {0x2b50, 0x2b50}, {0x2b55, 0x2b55},
+    {0x2e80, 0x3029}, {0x302e, 0x303e}, {0x3041, 0x3096}, {0x309b, 0x33ff}, {0x3400, 0x4dbf},
+    {0x4e00, 0x9fff}, {0xa000, 0xa4cf}, {0xa960, 0xa97f}, {0xac00, 0xd7a3}, {0xf900, 0xfaff},
+    {0xfe10, 0xfe19}, {0xfe30, 0xfe6f}, {0xff00, 0xff60}, {0xffe0, 0xffe6}, {0x16fe0, 0x16fe4},
+    {0x17000, 0x18cff}, {0x1b000, 0x1b2ff}, {0x1f004, 0x1f004}, {0x1f0cf, 0x1f0cf},
+    {0x1f18e, 0x1f18e}, {0x1f191, 0x1f19a}, {0x1f200, 0x1f202}, {0x1f210, 0x1f23b},
+    {0x1f240, 0x1f248}, {0x1f250, 0x1f251}, {0x1f260, 0x1f265}, {0x1f300, 0x1f320},
+    {0x1f32d, 0x1f335}, {0x1f337, 0x1f37c}, {0x1f37e, 0x1f393}, {0x1f3a0, 0x1f3ca},
+    {0x1f3cf, 0x1f3d3}, {0x1f3e0, 0x1f3f0}, {0x1f3f4, 0x1f3f4}, {0x1f3f8, 0x1f3fa},
+    {0x1f400, 0x1f43e}, {0x1f440, 0x1f440}, {0x1f442, 0x1f4fc}, {0x1f4ff, 0x1f53d},
+    {0x1f54b, 0x1f54e}, {0x1f550, 0x1f567}, {0x1f57a, 0x1f57a}, {0x1f595, 0x1f596},
+    {0x1f5a4, 0x1f5a4}, {0x1f5fb, 0x1f64f}, {0x1f680, 0x1f6c5}, {0x1f6cc, 0x1f6cc},
+    {0x1f6d0, 0x1f6d2}, {0x1f6d5, 0x1f6d7}, {0x1f6eb, 0x1f6ec}, {0x1f6f4, 0x1f6fc},
+    {0x1f7e0, 0x1f7eb}, {0x1f90c, 0x1f93a}, {0x1f93c, 0x1f945}, {0x1f947, 0x1f9ff},
+    {0x1fa70, 0x1faff}, {0x20000, 0x2fffd}, {0x30000, 0x3fffd},
+};
+
+#define RANGE_COUNT(table) (int)(sizeof(table) / sizeof(table[0]))
+
+static bool in_table(unsigned codepoint, const range_t* table, int count) {
+    if(codepoint < table[0].first || codepoint > table[count - 1].last) return false;
+    int low = 0, high = count - 1;
+    while(low <= high) {
+        int middle = (low + high) / 2;
+        if(codepoint > table[middle].last)
+            low = middle + 1;
+        else if(codepoint < table[middle].first)
+            high = middle - 1;
+        else
+            return true;
+    }
+    return false;
+}
+
+int term_codepoint_width(unsigned codepoint) {
+    if(codepoint < 0x20 || (codepoint >= 0x7f && codepoint < 0xa0)) return 0;
+    if(codepoint < 0x300) return 1;
+    if(in_table(codepoint, zeroWidth, RANGE_COUNT(zeroWidth))) return 0;
+    if(in_table(codepoint, doubleWidth, RANGE_COUNT(doubleWidth))) return 2;
+    return 1;
+}
+
+// MARK: - Scanning
+
+// Most text is printable ASCII, one column a byte, so we skip over runs of it as fast as we can:
+// 16 bytes at a time with SSE2, or 8 at a time in a 64-bit word otherwise.
+#define SWAR_ONES   0x0101010101010101ull
+#define SWAR_HIGHS  0x8080808080808080ull
+// Whether any byte of [word] is below [n] (up to 128), or above [n] (up to 127).
+#define SWAR_HAS_LESS(word, n) (((word) - SWAR_ONES * (n)) & ~(word) & SWAR_HIGHS)
+#define SWAR_HAS_MORE(word, n) ((((word) + SWAR_ONES * (127 - (n))) | (word)) & SWAR_HIGHS)
+
+// Returns how many bytes at the start of [bytes] are printable ASCII.
+static int ascii_run(const uint8_t* bytes, int length) {
+    int i = 0;
+#ifdef WIDTH_SSE2
+    const __m128i low = _mm_set1_epi8(0x1f);
+    const __m128i high = _mm_set1_epi8(0x7f);
+    for(; i + 16 <= length; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(bytes + i));
+        // Bytes past 0x7f are negative once signed, so they fail the first comparison.
+        __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(chunk, low), _mm_cmplt_epi8(chunk, high));
+        unsigned mask = _mm_movemask_epi8(printable);
+        if(mask != 0xffff) return i + __builtin_ctz(~mask);
+    }
+#else
+    for(; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        if(SWAR_HAS_LESS(word, 0x20) | SWAR_HAS_MORE(word, 0x7e)) break;
+    }
+#endif
+    while(i < length && bytes[i] >= 0x20 && bytes[i] < 0x7f) i += 1;
+    return i;
+}
+
+// Returns the length of the escape sequence at the start of [bytes]. Sequences cut short by the
+// end of the text take up the rest of it.
+static int escape_length(const uint8_t* bytes, int length) {
+    if(length < 2) return length;
+    int i = 2;
+    switch(bytes[1]) {
+    case '[':
+        // Parameters and intermediates, then a final byte.
+        while(i < length && bytes[i] >= 0x20 && bytes[i] < 0x40) i += 1;
+        return i < length ? i + 1 : length;
+
+    case ']':
+    case 'P':
+    case '_':
+    case '^':
+    case 'X':
+        // Strings end with ST (ESC \). OSC can also end with BEL.
+        for(; i < length; ++i) {
+            if(bytes[i] == '\a' && bytes[1] == ']') return i + 1;
+            if(bytes[i] == 0x1b && i + 1 < length && bytes[i + 1] == '\\') return i + 2;
+        }
+        return length;
+
+    default:
+        // ESC, intermediates, and a final byte, like ESC ( B.
+        i = 1;
+        while(i < length && bytes[i] >= 0x20 && bytes[i] < 0x30) i += 1;
+        return i < length ? i + 1 : length;
+    }
+}
+
+// Decodes the UTF-8 sequence at the start of [bytes]. Returns its length, or 0 if it isn't valid.
+static int decode_utf8(const uint8_t* bytes, int length, unsigned* codepoint) {
+    uint8_t c = bytes[0];
+    int count;
+    unsigned min, max;
+    if(c >= 0xc2 && c < 0xe0) {
+        count = 2;
+        *codepoint = c & 0x1f;
+        min = 0x80;
+        max = 0xbf;
+    } else if(c >= 0xe0 && c < 0xf0) {
+        count = 3;
+        *codepoint = c & 0x0f;
+        // No overlong forms, and no surrogates.
+        min = c == 0xe0 ? 0xa0 : 0x80;
+        max = c == 0xed ? 0x9f : 0xbf;
+    } else if(c >= 0xf0 && c < 0xf5) {
+        count = 4;
+        *codepoint = c & 0x07;
+        // No overlong forms, and nothing past U+10FFFF.
+        min = c == 0xf0 ? 0x90 : 0x80;
+        max = c == 0xf4 ? 0x8f : 0xbf;
+    } else {
+        return 0;
+    }
+    if(count > length || bytes[1] < min || bytes[1] > max) return 0;
+    for(int i = 1; i < count; ++i) {
+        if((bytes[i] & 0xc0) != 0x80) return 0;
+        *codepoint = *codepoint << 6 | (bytes[i] & 0x3f);
+    }
+    return count;
+}
+
+int term_display_width(const char* str, int length) {
+    assert((str || !length) && "cannot measure a null string");
+    const uint8_t* bytes = (const uint8_t*)str;
+    int width = 0;
+    int i = 0;
+    while(i < length) {
+        int run = ascii_run(bytes + i, length - i);
+        width += run;
+        i += run;
+        if(i >= length) break;
+
+        uint8_t c = bytes[i];
+        if(c == 0x1b) {
+            i += escape_length(bytes + i, length - i);
+        } else if(c < 0x80) {
+            i += 1; // Control characters don't take any space.
+        } else {
+            unsigned codepoint;
+            int count = decode_utf8(bytes + i, length - i, &codepoint);
+            width += count ? term_codepoint_width(codepoint) : 1;
+            i += count ? count : 1;
+        }
+    }
+    return width;
+}
@@ -0,0 +1,229 @@
+//===--------------------------------------------------------------------------------------------===
+// render_test.c - checks what the editors draw, and what it costs, on a virtual terminal
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#include <term/editor.h>
+#include <term/hexes.h>
+#include <term/line.h>
+#include <term/screen.h>
+#include <term/vterm.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WIDTH 80
+#define HEIGHT 24
+#define LINES 400
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if(!(cond)) { \
+        fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fputc('\n', stderr); \
+        failures += 1; \
+    } \
+} while(0)
+
+static void check_row(hexes_vt_t* vt, int y, const char* expected, int line) {
+    char row[WIDTH + 1];
+    hexes_vt_row(vt, y, row);
+    if(strcmp(row, expected)) {
+        fprintf(stderr, "%s:%d: row %d is \"%s\", expected \"%s\"\n", __FILE__, line, y, row,
+                expected);
+        failures += 1;
+    }
+}
+#define CHECK_ROW(vt, y, expected) check_row((vt), (y), (expected), __LINE__)
+
+// Checks what the last batch of events cost against a budget: each event should be drawn in at
+// most one synchronized frame, and with at most [bytes] bytes.
+static void check_cost(hexes_vt_t* vt, const char* name, int events, long bytes, int line) {
+    const hexes_vt_stats_t* stats = hexes_vt_stats(vt);
+    if(getenv("RENDER_TEST_VERBOSE")) {
+        printf("%-16s %6.1f bytes/event  %4.2f frames/event\n", name,
+               (double)stats->bytes / events, (double)stats->syncFrames / events);
+    }
+    if(stats->syncFrames > events) {
+        fprintf(stderr, "%s:%d: %s took %ld frames for %d events\n", __FILE__, line, name,
+                stats->syncFrames, events);
+        failures += 1;
+    }
+    if(stats->bytes > bytes * events) {
+        fprintf(stderr, "%s:%d: %s sent %.1f bytes per event, over the budget of %ld\n",
+                __FILE__, line, name, (double)stats->bytes / events, bytes);
+        failures += 1;
+    }
+}
+#define CHECK_COST(vt, name, events, bytes) check_cost((vt), (name), (events), (bytes), __LINE__)
+
+// MARK: - Editor
+
+// Sends [key] [count] times, rendering after each event like an interactive session would.
+static void editor_keys(hexes_vt_t* vt, const char* key, int count) {
+    hexes_vt_reset_stats(vt);
+    for(int i = 0; i < count; ++i) {
+        hexes_vt_input(vt, key, strlen(key));
+        hexes_event_t event;
+        while(hexes_poll_event(&event, 0) > 0) {
+            termEditorHandle(&event);
+            termEditorRender();
+        }
+    }
+}
+
+static void test_editor(hexes_vt_t* vt) {
+    static char text[LINES * 16];
+    int length = 0;
+    for(int i = 0; i < LINES; ++i) {
+        length += snprintf(text + length, sizeof(text) - length, "line %d\n", i + 1);
+    }
+
+    termEditorInit("test");
+    termEditorReplace(text);
+    termEditorRender();
+    CHECK_ROW(vt, 0, "  1 line 1");
+    CHECK_ROW(vt, HEIGHT - 3, " 22 line 22");
+
+    editor_keys(vt, "x", 10);
+    CHECK_ROW(vt, 0, "  1 xxxxxxxxxxline 1");
+    CHECK_COST(vt, "typing", 10, 80);
+    int x = 0, y = 0;
+    hexes_vt_cursor(vt, &x, &y);
+    CHECK(x == 14 && y == 0, "cursor at (%d, %d) after typing, expected (14, 0)", x, y);
+
+    editor_keys(vt, "\033[B", 40);
+    CHECK_ROW(vt, 0, " 20 line 20");
+    CHECK_ROW(vt, HEIGHT - 3, " 41 line 41");
+    CHECK_COST(vt, "scrolling", 40, 100);
+
+    editor_keys(vt, "\033[A", 40);
+    CHECK_ROW(vt, 0, "  1 xxxxxxxxxxline 1");
+    CHECK_COST(vt, "scrolling back", 40, 100);
+
+    termEditorDeinit();
+}
+
+// MARK: - Screen
+
+static void check_cell(hexes_vt_t* vt, int x, hexes_style_t expected, int line) {
+    hexes_style_t style = hexes_vt_cell(vt, x, 0).style;
+    if(style.fg != expected.fg || style.bg != expected.bg || style.attrs != expected.attrs) {
+        fprintf(stderr, "%s:%d: cell %d is %d/%d with %d, expected %d/%d with %d\n",
+                __FILE__, line, x, style.fg, style.bg, style.attrs, expected.fg, expected.bg,
+                expected.attrs);
+        failures += 1;
+    }
+}
+#define CHECK_CELL(vt, x, expected) check_cell((vt), (x), (expected), __LINE__)
+
+static void test_screen(hexes_vt_t* vt) {
+    const hexes_style_t styles[] = {
+        HEXES_STYLE(TERM_BRIGHT_WHITE, TERM_DEFAULT, 0),
+        HEXES_STYLE(TERM_DEFAULT, TERM_BRIGHT_BLUE, 0),
+        HEXES_STYLE(TERM_RED, TERM_BRIGHT_BLACK, 0),
+        HEXES_STYLE(TERM_BRIGHT_GREEN, TERM_BLUE, HEXES_ATTR_BOLD),
+        HEXES_STYLE(TERM_WHITE, TERM_DEFAULT, 0),
+    };
+    int count = sizeof(styles) / sizeof(styles[0]);
+
+    // Bright colours come out as themselves, not as the normal colour with bold.
+    hexes_screen_t* screen = hexes_screen_new(WIDTH, HEIGHT);
+    for(int i = 0; i < count; ++i) hexes_screen_put(screen, i, 0, 'a' + i, styles[i]);
+    hexes_screen_present(screen);
+    CHECK_ROW(vt, 0, "abcde");
+    for(int i = 0; i < count; ++i) CHECK_CELL(vt, i, styles[i]);
+    hexes_screen_destroy(screen);
+}
+
+// MARK: - Line editor
+
+static line_action_t line_keys(hexes_vt_t* vt, line_t* line, const char* keys, char** result) {
+    hexes_vt_reset_stats(vt);
+    hexes_vt_input(vt, keys, strlen(keys));
+    line_action_t action = LINE_STAY;
+    hexes_event_t event;
+    while(hexes_poll_event(&event, 0) > 0) {
+        action = line_handle(line, &event, result);
+        if(action == LINE_RETURN || action == LINE_DONE) break;
+    }
+    return action;
+}
+
+static void print_prompt(const char* prompt) {
+    hexes_printf("[%s] ", prompt);
+}
+
+static void test_line(hexes_vt_t* vt) {
+    line_functions_t functions = {.print_prompt = print_prompt};
+    line_t* line = line_new(&functions);
+    line_set_prompt(line, "test");
+    char* result = NULL;
+
+    line_start(line);
+    CHECK_ROW(vt, 0, "[test]");
+
+    // One key at a time, each drawn as it comes.
+    for(const char* c = "hello"; *c; ++c) line_keys(vt, line, (char[]){*c, 0}, &result);
+    CHECK_ROW(vt, 0, "[test] hello");
+    CHECK_COST(vt, "line typing", 1, 24);
+
+    line_keys(vt, line, "\033[D\033[D", &result);
+    line_keys(vt, line, "X", &result);
+    CHECK_ROW(vt, 0, "[test] helXlo");
+    int x = 0, y = 0;
+    hexes_vt_cursor(vt, &x, &y);
+    CHECK(x == 11 && y == 0, "cursor at (%d, %d) after inserting, expected (11, 0)", x, y);
+
+    // A burst of input is drawn once.
+    line_keys(vt, line, "\033[200~ world\033[201~!!!", &result);
+    CHECK_ROW(vt, 0, "[test] helX world!!!lo");
+    CHECK_COST(vt, "line burst", 1, 64);
+
+    line_action_t action = line_keys(vt, line, "\r", &result);
+    CHECK(action == LINE_RETURN, "enter returned %d, expected LINE_RETURN", action);
+    CHECK(result && !strcmp(result, "helX world!!!lo\n"), "line is \"%s\"", result ? result : "");
+    free(result);
+
+    // The next line starts from an empty buffer, even when a burst redraws it before any edit.
+    line_start(line);
+    line_keys(vt, line, "\033[D\033[D", &result);
+    line_keys(vt, line, "ok", &result);
+    // Pasted line breaks don't end or split the line.
+    line_keys(vt, line, "\033[200~ a\r\nb\nc\033[201~", &result);
+    CHECK_ROW(vt, 1, "[test] ok a b c");
+    action = line_keys(vt, line, "\r", &result);
+    CHECK(action == LINE_RETURN, "enter returned %d, expected LINE_RETURN", action);
+    CHECK(result && !strcmp(result, "ok a b c\n"), "second line is \"%s\"", result ? result : "");
+    free(result);
+    line_destroy(line);
+}
+
+int main() {
+    hexes_vt_t* vt = hexes_vt_new(WIDTH, HEIGHT);
+    hexes_set_backend(hexes_vt_backend(vt));
+    test_editor(vt);
+    hexes_set_backend(NULL);
+    hexes_vt_destroy(vt);
+
+    vt = hexes_vt_new(WIDTH, HEIGHT);
+    hexes_set_backend(hexes_vt_backend(vt));
+    test_screen(vt);
+    hexes_set_backend(NULL);
+    hexes_vt_destroy(vt);
+
+    vt = hexes_vt_new(WIDTH, HEIGHT);
+    hexes_set_backend(hexes_vt_backend(vt));
+    test_line(vt);
+    hexes_set_backend(NULL);
+    hexes_vt_destroy(vt);
+
+    if(failures) fprintf(stderr, "%d checks failed\n", failures);
+    return failures ? 1 : 0;
+}
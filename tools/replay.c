@@ -0,0 +1,248 @@
+//===--------------------------------------------------------------------------------------------===
+// replay.c - plays asciicast recordings back into the terminal
+// This source is part of TermUtils
+//
+// Created on 2026-10-16 by Amy Parent <amy@amyparent.com>
+// Copyright (c) 2026 Amy Parent
+// Licensed under the MIT License
+// =^•.•^=
+//===--------------------------------------------------------------------------------------------===
+#define _POSIX_C_SOURCE 200809L
+#include <term/arg.h>
+#include <term/hexes.h>
+#include <term/printing.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PROGRAM "termutils-replay"
+
+static const term_param_t params[] = {
+    {'s', 0, "speed", TERM_ARG_VALUE, "play back at [value] times the original speed"},
+    {'i', 0, "idle", TERM_ARG_VALUE, "wait at most [value] seconds between two frames"},
+};
+#define PARAM_COUNT (int)(sizeof(params) / sizeof(params[0]))
+
+static const char* uses[] = {"[options] recording.cast"};
+
+static int64_t now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// MARK: - Reading recordings
+// Events are JSON arrays on a line of their own: [time, "kind", "data"]. We only need enough of a
+// JSON parser to read those.
+
+typedef struct {
+    double time;
+    char kind;
+    char* data;
+    int length;
+} cast_event_t;
+
+static const char* skip_space(const char* str) {
+    while(*str == ' ' || *str == '\t') str += 1;
+    return str;
+}
+
+static int hex_value(const char* str) {
+    int value = 0;
+    for(int i = 0; i < 4; ++i) {
+        char c = str[i];
+        value <<= 4;
+        if(c >= '0' && c <= '9')
+            value |= c - '0';
+        else if(c >= 'a' && c <= 'f')
+            value |= c - 'a' + 10;
+        else if(c >= 'A' && c <= 'F')
+            value |= c - 'A' + 10;
+        else
+            return -1;
+    }
+    return value;
+}
+
+static int put_utf8(char* out, unsigned code) {
+    if(code < 0x80) {
+        out[0] = code;
+        return 1;
+    }
+    if(code < 0x800) {
+        out[0] = 0xc0 | (code >> 6);
+        out[1] = 0x80 | (code & 0x3f);
+        return 2;
+    }
+    if(code < 0x10000) {
+        out[0] = 0xe0 | (code >> 12);
+        out[1] = 0x80 | ((code >> 6) & 0x3f);
+        out[2] = 0x80 | (code & 0x3f);
+        return 3;
+    }
+    out[0] = 0xf0 | (code >> 18);
+    out[1] = 0x80 | ((code >> 12) & 0x3f);
+    out[2] = 0x80 | ((code >> 6) & 0x3f);
+    out[3] = 0x80 | (code & 0x3f);
+    return 4;
+}
+
+// Decodes the JSON string at [str] in place: the decoded text is never longer than its escaped
+// form. Returns a pointer past the closing quote, or NULL if the string is malformed.
+static char* read_string(char* str, char** data, int* length) {
+    if(*str != '"') return NULL;
+    char* out = ++str;
+    *data = out;
+    while(*str && *str != '"') {
+        if(*str != '\\') {
+            *out++ = *str++;
+            continue;
+        }
+        str += 1;
+        switch(*str++) {
+        case '"': *out++ = '"'; break;
+        case '\\': *out++ = '\\'; break;
+        case '/': *out++ = '/'; break;
+        case 'b': *out++ = '\b'; break;
+        case 'f': *out++ = '\f'; break;
+        case 'n': *out++ = '\n'; break;
+        case 'r': *out++ = '\r'; break;
+        case 't': *out++ = '\t'; break;
+        case 'u': {
+            int code = hex_value(str);
+            if(code < 0) return NULL;
+            str += 4;
+            if(code >= 0xd800 && code < 0xdc00 && str[0] == '\\' && str[1] == 'u') {
+                int low = hex_value(str + 2);
+                if(low >= 0xdc00 && low < 0xe000) {
+                    code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                    str += 6;
+                }
+            }
+            out += put_utf8(out, code);
+            break;
+        }
+        default:
+            return NULL;
+        }
+    }
+    if(*str != '"') return NULL;
+    *length = out - *data;
+    return str + 1;
+}
+
+static bool read_event(char* line, cast_event_t* event) {
+    char* str = (char*)skip_space(line);
+    if(*str++ != '[') return false;
+    event->time = strtod(str, &str);
+    str = (char*)skip_space(str);
+    if(*str++ != ',') return false;
+
+    char* kind;
+    int kindLength;
+    str = read_string((char*)skip_space(str), &kind, &kindLength);
+    if(!str || kindLength != 1) return false;
+    event->kind = kind[0];
+
+    str = (char*)skip_space(str);
+    if(*str++ != ',') return false;
+    return read_string((char*)skip_space(str), &event->data, &event->length) != NULL;
+}
+
+// MARK: - Playback
+
+typedef enum { PLAY_ON, PLAY_QUIT } play_status_t;
+
+// Waits [delay] milliseconds, while handling keys: q quits, and space pauses until it's pressed
+// again.
+static play_status_t wait_for(int64_t delay) {
+    int64_t deadline = now_ms() + delay;
+    bool paused = false;
+    for(;;) {
+        int64_t remaining = deadline - now_ms();
+        if(!paused && remaining <= 0) return PLAY_ON;
+
+        hexes_event_t event;
+        int64_t start = now_ms();
+        int status = hexes_poll_event(&event, paused ? -1 : (int)remaining);
+        if(status < 0) return PLAY_ON;
+        if(paused) deadline += now_ms() - start;
+        if(status == 0 || event.kind != HEXES_EVENT_KEY) continue;
+
+        if(event.key == 'q' || event.key == KEY_CTRL_C) return PLAY_QUIT;
+        if(event.key == ' ') paused = !paused;
+    }
+}
+
+static void play(FILE* in, double speed, double idle) {
+    char* line = NULL;
+    size_t capacity = 0;
+    double last = 0;
+    bool header = true;
+
+    while(getline(&line, &capacity, in) > 0) {
+        if(header) {
+            header = false;
+            if(*skip_space(line) != '{') term_error(PROGRAM, 1, "not an asciicast recording");
+            continue;
+        }
+
+        cast_event_t event;
+        if(!read_event(line, &event)) continue;
+        if(event.kind != 'o') continue;
+
+        double delay = event.time - last;
+        last = event.time;
+        if(idle >= 0 && delay > idle) delay = idle;
+        if(delay > 0 && wait_for((int64_t)(delay * 1000 / speed)) == PLAY_QUIT) break;
+
+        hexes_frame_begin();
+        hexes_write(event.data, event.length);
+        hexes_frame_end();
+    }
+    free(line);
+}
+
+int main(int argc, const char** argv) {
+    double speed = 1;
+    double idle = -1;
+    const char* path = NULL;
+
+    term_arg_parser_t parser;
+    term_arg_parser_init(&parser, argc, argv);
+
+    term_arg_result_t result;
+    while((result = term_arg_parse(&parser, params, PARAM_COUNT)).name != TERM_ARG_DONE) {
+        switch(result.name) {
+        case 's':
+            speed = atof(result.value);
+            if(speed <= 0) term_error(PROGRAM, 1, "speed must be more than 0");
+            break;
+        case 'i':
+            idle = atof(result.value);
+            break;
+        case TERM_ARG_POSITIONAL:
+            path = result.value;
+            break;
+        case TERM_ARG_HELP:
+            term_print_usage(stdout, PROGRAM, uses, 1);
+            term_print_help(stdout, params, PARAM_COUNT);
+            return 0;
+        case TERM_ARG_ERROR:
+            term_error(PROGRAM, 1, "%s", parser.error);
+            break;
+        }
+    }
+    if(!path) term_error(PROGRAM, 1, "no recording to play");
+
+    FILE* in = fopen(path, "r");
+    if(!in) term_error(PROGRAM, 1, "cannot open '%s'", path);
+
+    hexes_session_begin();
+    play(in, speed, idle);
+    hexes_session_end();
+    fclose(in);
+    return 0;
+}